@@ -0,0 +1,64 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(ANCHOR_SET_HPP)
+#define ANCHOR_SET_HPP
+
+#include <vector>
+
+#include "point.hpp"
+
+// Decides which side of text inserted right at an anchor it ends up on
+enum class AnchorGravity
+{
+	Left, // Stays before the new text (like the mark)
+	Right, // Moves to after the new text (like the point)
+};
+
+// The positions in a buffer that have to follow its text around, like
+// the point and mark of every frame showing it. The points belong to
+// whoever added them, the set only moves them when the buffer is edited
+// (once per edit, not once per character).
+class AnchorSet
+{
+private:
+	struct Anchor
+	{
+		Point* point;
+		AnchorGravity gravity;
+	};
+
+	std::vector<Anchor> anchors;
+
+public:
+	// A change made as part of a batch, in positions from before the batch
+	struct Edit
+	{
+		Point start;
+		Point end; // The same as start for an insertion
+		unsigned int numberOfNewlines = 0; // In the text put in
+		unsigned int lastLineSize = 0; // Of the text put in
+	};
+
+public:
+	void add(Point* point, AnchorGravity gravity);
+	void remove(Point* point);
+	void remove(std::vector<Point*> points);
+	unsigned int size() const { return (unsigned int) anchors.size(); }
+
+	void moveForInsertion(const Point& start, const Point& end);
+	void moveForDeletion(const Point& start, const Point& end);
+	// The edits have to be sorted and not overlap. Each anchor is only
+	// moved once for the whole batch.
+	void moveForEdits(const std::vector<Edit>& edits);
+
+	template<typename Function>
+	void forEach(Function function)
+	{
+		for (Anchor& anchor : anchors)
+		{
+			function(*anchor.point);
+		}
+	}
+};
+
+#endif
@@ -4,30 +4,74 @@
 #define BUFFER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <deque>
 #include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include <climits>
 
 // NOTE(fkp): This is for DWORD, including <windows.h> gives errors
 // for some reason.
 #include <IntSafe.h>
 
 #include "point.hpp"
+#include "piece_table.hpp"
+#include "paged_file.hpp"
+#include "file_loader.hpp"
+#include "file_saver.hpp"
+#include "shell_filter.hpp"
+#include "journal.hpp"
+#include "timer.hpp"
 #include "undo.hpp"
+#include "undo_tree.hpp"
+#include "anchor_set.hpp"
 #include "lexer.hpp"
+#include "lex_worker.hpp"
 
 class Frame;
 
+// Replaces part of one line, the text can't contain newlines
+struct LineEdit
+{
+	unsigned int startCol = 0;
+	unsigned int endCol = 0;
+	std::string text;
+};
+
 enum class BufferType
 {
 	MiniBuffer,
 	Text,
+	Snapshot, // A copy of some text to work on in the background
+};
+
+enum class FileOpenMode
+{
+	Normal,
+	Mapped, // Unedited lines are views into a mapping of the file
+	Paged, // Read only, only a window of lines is loaded at a time
 };
 
+constexpr unsigned int PAGED_WINDOW_NUMBER_OF_LINES = 8192;
+// The window is moved when a frame gets this close to either end
+constexpr unsigned int PAGED_WINDOW_MARGIN = 1024;
+constexpr double COMPACT_AFTER_IDLE_MS = 2000.0;
+// Lexing after an edit stops this far past it, the rest is done in the
+// background. This is more than a frame can show.
+constexpr unsigned int FOREGROUND_LEX_NUMBER_OF_LINES = 256;
+
 class Buffer
 {
 public:
 	inline static std::unordered_map<std::string, Buffer*> buffersMap;
+
+	// Saves that overlap are reported together once they have all
+	// finished.
+	inline static unsigned int numberOfSavesInProgress = 0;
+	inline static unsigned int numberOfSavesInBatch = 0;
+	inline static std::uint64_t numberOfBytesSavedInBatch = 0;
+	inline static Timer saveBatchTimer;
 	
 	bool isReadOnly = false;
 	unsigned int numberOfActionsSinceSave = 0;
@@ -36,22 +80,76 @@ public:
 	std::string name;
 	std::string path;
 	
-	std::vector<std::string> data;
+	PieceTable data;
+	FileOpenMode openMode = FileOpenMode::Normal;
+
+	// NOTE(fkp): For paged buffers, data only holds the lines in the
+	// window and all line numbers are relative to the window.
+	std::unique_ptr<PagedFile> pagedFile;
+	std::vector<std::uint64_t> pagedLineOffsets; // File offset of each line in data
+	std::uint64_t pagedEndOffset = 0;
+	std::uint64_t firstPagedLine = 0;
+	bool isFirstPagedLineKnown = true;
+
+	// NOTE(fkp): While a file is loading, the lines that are read are
+	// added before the empty last line.
+	std::unique_ptr<FileLoader> loader;
+	unsigned int numberOfLoadedLines = 0;
+
+	std::unique_ptr<FileSaver> saver;
+	unsigned int numberOfActionsBeingSaved = 0;
+	// The saved file only matches the buffer if this hasn't changed since
+	unsigned int numberOfEditsBeingSaved = 0;
+
+	// The region being run through a shell command, which replaces it
+	// once the command is done
+	std::unique_ptr<ShellFilter> shellFilter;
+
+	// Unsaved edits are recorded here in case the editor dies
+	Journal journal;
+
+	// Identical unedited lines share their text, this is redone whenever
+	// the file is loaded again.
+	bool isInterningLines = false;
+
+	// The line arena is compacted once there have been no edits for a while
+	unsigned int numberOfEditsAtLastUpdate = 0;
+	Timer timeSinceLastEdit;
+	
 	Lexer lexer;
 	bool isUsingSyntaxHighlighting = false;
 	std::unordered_map<std::string, std::string> functionDefinitions;
+
+	// Lines from this one to the end still have to be lexed, which the
+	// lex worker does with a copy of them.
+	std::unique_ptr<LexWorker> lexWorker;
+	unsigned int firstLineToLexInBackground = UINT_MAX;
+	// Lines added or removed before the worker's copy only move it, any
+	// edit to the copied lines means it has to be started again.
+	int backgroundLexLineShift = 0;
+	bool isBackgroundLexStale = false;
 	
-	bool shouldAddToUndoInformation = true;
-	std::deque<Action> undoInformation;
-	unsigned int undoInformationPointer = 0;
+	UndoTree undoTree;
+
+	// Edits made in a transaction are lexed once it's committed, and are
+	// one step in the undo history.
+	std::vector<bool> openTransactions; // Whether each one records undo
+	unsigned int numberOfTransactionsNotRecordingUndo = 0;
+	bool hasStartedUndoGroup = false;
+	unsigned int firstLineToLex = UINT_MAX;
+	unsigned int lastLineToLex = 0;
 	
 	// The frame will take a copy of this when opened, and the last
 	// frame to close this buffer will write its values in.
 	Point lastPoint;
 	unsigned int lastTopLine = 0;
+
+	// Everything that follows edits, including lastPoint and the point
+	// and mark of each frame showing this buffer
+	AnchorSet anchors;
 	
 public:
-	Buffer(BufferType type, std::string name, std::string path);
+	Buffer(BufferType type, std::string name, std::string path, FileOpenMode openMode = FileOpenMode::Normal);
 	~Buffer();
 	Buffer(const Buffer&) = delete;
 	Buffer& operator=(const Buffer&) = delete;
@@ -60,19 +158,116 @@ public:
 	
 	static Buffer* get(const std::string& name);
 	static Buffer* getFromFilePath(const std::string& path);
+
+	// Background work, this is called once per frame
+	void update();
 	
-	void addActionToUndoBuffer(Action&& action);
-	bool undo(Frame& frame);
-	bool redo(Frame& frame);
+	// These change a whole range at once, and update the lexer, the
+	// points of frames showing the buffer and the undo information once.
+	// insertText() returns where the inserted text ends.
+	Point insertText(const Point& start, std::string_view text);
+	std::string eraseRange(const Point& start, const Point& end);
+	// These do the same edit at many places in one pass, as one step in
+	// the undo history. The points and ranges have to be sorted, and the
+	// ranges can't overlap.
+	void insertTextAtPoints(const std::vector<Point>& points, std::string_view text);
+	void eraseRanges(const std::vector<std::pair<Point, Point>>& ranges);
+	// Replaces whole lines with the text in one go, which is lexed once
+	// and is one step in the undo history.
+	Point replaceLines(unsigned int firstLine, unsigned int lastLine, std::string_view text);
+	// Does one edit on each line from firstLine on. The lines are
+	// rebuilt in one pass and replaced at once, but everything that
+	// follows edits moves as if each line was edited on its own.
+	void editLines(unsigned int firstLine, const std::vector<LineEdit>& edits);
+
+	// Transactions can be nested, only the outermost one publishes the
+	// changes. Edits that come from the undo history don't record undo.
+	void beginTransaction(bool shouldRecordUndo = true);
+	void commitTransaction();
+	bool isInTransaction() const;
+	// Lexes the lines again now, or once the transaction is committed.
+	// Anything that changes because of them past the lines shown is
+	// lexed in the background.
+	void lexLines(unsigned int firstLine, unsigned int lastLine);
+	void lexWholeBuffer();
+	void lexInBackground(unsigned int firstLine);
+	void updateBackgroundLexing();
+
+	void addActionToUndoBuffer(ActionType type, const Point& start, const Point& end, std::string_view text);
+	// Each action is applied as one change, point is moved to where
+	// it happened.
+	bool undo(Point& point);
+	bool redo(Point& point);
+	// Saving happens in the background, updateSaving() finishes it
 	void saveToFile();
-	void revertToFile();
+	void updateSaving();
+	void finishSaving();
+	static void finishAllSaves();
+	static void discardAllJournals();
+	// Keeping the journal is only for when it is about to be recovered
+	void revertToFile(bool shouldKeepJournal = false);
+
+	// The command runs in the background, updateShellFilter() puts its
+	// output in place of the region once it is done.
+	bool startShellFilter(const std::string& command, const Point& start, const Point& end);
+	void cancelShellFilter();
+	bool isRunningShellFilter() const;
+	void updateShellFilter();
 
-	// NOTE(fkp): Calls the standalone substrFromPoints() function
-	// with the buffer's string.
 	std::string substrFromPoints(const Point& start, const Point& end);
+
+	// Offsets are the number of characters from the start of the
+	// buffer, with one character for each newline.
+	std::size_t offsetOf(const Point& point) const;
+	Point pointAt(std::size_t offset) const;
+	std::size_t distance(const Point& a, const Point& b) const;
+
+	// Searches forward from (but not including) the start point
+	bool findText(const Point& start, const std::string& text, Point& result);
+
+	// Paged buffers
+	bool isPaged() const;
+	void loadPage(std::uint64_t startOffset, std::uint64_t startLine, bool isStartLineKnown);
+	void ensurePagedLinesLoaded(int firstLine, unsigned int numberOfLines);
+	void shiftPage(int numberOfLines);
+	void pageToStart();
+	void pageToEnd();
+	bool getFirstPagedLine(std::uint64_t& line);
+
+	// Returns the number of distinct lines
+	unsigned int internLines();
+
+	// Progressive loading
+	bool isLoading() const;
+	// Adds any lines that have been read since the last call
+	void updateLoading();
+	// Blocks until the whole file is in the buffer
+	void finishLoading();
+
+private:
+	void clampFramePoints();
+	void onSaveFinished();
+	void recoverFromJournal(std::vector<Action>& actions);
+	// Applies an action straight to the data, without going through a frame
+	void applyAction(const Action& action);
+	// Does the actions one after another, point is moved to where the
+	// last one happened. Actions that are all in order without touching
+	// are done as one batch of edits.
+	void doActions(const std::vector<Action>& actions, Point& point);
+	// These are sorted and in positions from before any of the actions
+	bool getActionsAsEdits(const std::vector<Action>& actions, std::vector<Action>& edits);
+	// These only change the data
+	Point insertIntoData(const Point& start, std::string_view text);
+	void eraseFromData(const Point& start, const Point& end);
+	void shiftLinesToLex(unsigned int line, int numberOfLines);
+	// Where the lex worker's copy starts now, after the edits since
+	unsigned int getBackgroundLexFirstLine() const;
+	void discardBackgroundLex();
 };
 
 std::string substrFromPoints(const std::string& string, const Point& start, const Point& end, unsigned int offset);
 Point getPointAtEndOfString(const std::string& string, unsigned int lineOffset);
+// Where the point ends up after inserting the text at start
+Point getPointAfterText(const Point& start, const std::string& text);
 
 #endif
@@ -0,0 +1,24 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(CHILD_PROCESS_HPP)
+#define CHILD_PROCESS_HPP
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <string>
+
+// A process with pipes for its STDIN and STDOUT (which STDERR also goes
+// to). Whoever started it has to close these handles.
+struct ChildProcess
+{
+	HANDLE process = nullptr;
+	HANDLE stdInWrite = nullptr;
+	HANDLE stdOutRead = nullptr;
+	// Only if it was started in a job. Everything the process starts is
+	// also in the job, and all of it is killed when this is closed.
+	HANDLE job = nullptr;
+};
+
+bool startChildProcess(const std::string& command, ChildProcess& childProcess, bool shouldStartInJob = false);
+
+#endif
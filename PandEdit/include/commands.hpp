@@ -15,6 +15,7 @@ enum class MinibufferReading
 	Path,
 	BufferName,
 	Confirmation,
+	SearchText,
 };
 
 class Window;
@@ -44,6 +44,7 @@ void mapDefaultKeyBindings()
 	KeyMap::bindKey({ Key::PageUp }, "pageUp");
 	KeyMap::bindKey({ Key::PageDown }, "pageDown");
 	KeyMap::bindKey({ Key::L, KEY_CONTROL }, "centerPoint");
+	KeyMap::bindKey({ Key::S, KEY_CONTROL }, "searchForward");
 
 	KeyMap::bindKey({ Key::C, KEY_CONTROL }, "copyRegion");
 	KeyMap::bindKey({ Key::V, KEY_CONTROL }, "paste");
@@ -63,6 +64,10 @@ void mapDefaultKeyBindings()
 	KeyMap::bindKey({ Key::DownArrow, KEY_CONTROL }, "nextSuggestion");
 
 	KeyMap::bindKey({ Key::M, KEY_ALT }, "compile");
+
+	KeyMap::bindKey({ Key::F3 }, "startMacro");
+	KeyMap::bindKey({ Key::F4 }, "endMacro");
+	KeyMap::bindKey({ Key::F5 }, "replayMacro");
 }
 
 #endif
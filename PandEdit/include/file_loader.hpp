@@ -0,0 +1,57 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(FILE_LOADER_HPP)
+#define FILE_LOADER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Loads a file in the background. The start of the file is read
+// straight away so it can be shown, then the rest is read in chunks on
+// a worker thread and handed over a few whole lines at a time.
+class FileLoader
+{
+public:
+	// Enough for the first screen (and a lot more) of most files
+	static constexpr std::size_t FIRST_PART_SIZE = 256 * 1024;
+	static constexpr std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+private:
+	std::string path;
+	std::uint64_t fileSize = 0;
+
+	// Whole lines that have been read but not taken yet
+	std::string loadedText;
+	std::mutex loadedTextMutex;
+	std::atomic<std::uint64_t> numberOfBytesRead = 0;
+	std::atomic<bool> isThreadDone = true;
+	std::atomic<bool> shouldStop = false;
+	std::thread loadThread;
+
+public:
+	FileLoader() = default;
+	~FileLoader();
+	FileLoader(const FileLoader&) = delete;
+	FileLoader& operator=(const FileLoader&) = delete;
+
+	// Gives the first lines of the file, with the same line endings as
+	// readFile(). Returns false if the whole file was read.
+	bool start(const std::string& filePath, std::string& firstPart);
+	void stop();
+
+	// Gives any lines that have been read since the last call
+	bool takeLoadedText(std::string& text);
+	// Blocks until the whole file has been read
+	void waitUntilFinished();
+
+	bool isFinished();
+	double getProgress() const;
+
+private:
+	void loadRestOfFile(std::uint64_t startOffset);
+};
+
+#endif
@@ -0,0 +1,38 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(FILE_MAPPING_HPP)
+#define FILE_MAPPING_HPP
+
+#include <cstddef>
+#include <string>
+
+// A read-only view of a whole file mapped into memory. The contents
+// are paged in by the OS as they are touched.
+class FileMapping
+{
+private:
+	// NOTE(fkp): These are HANDLEs, but <windows.h> can't be included
+	// in headers that end up in buffer.hpp.
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+
+	const char* mappedData = nullptr;
+	std::size_t mappedSize = 0;
+
+public:
+	FileMapping() = default;
+	~FileMapping();
+	FileMapping(const FileMapping&) = delete;
+	FileMapping& operator=(const FileMapping&) = delete;
+	FileMapping(FileMapping&& other);
+	FileMapping& operator=(FileMapping&& other);
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const { return mappedData != nullptr || fileHandle != nullptr; }
+	const char* data() const { return mappedData; }
+	std::size_t size() const { return mappedSize; }
+};
+
+#endif
@@ -0,0 +1,51 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(FILE_SAVER_HPP)
+#define FILE_SAVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+// Writes a file on a background thread. The contents go to a
+// temporary file next to the target, which is flushed to disk and then
+// renamed over it, so the old file is never left half written.
+class FileSaver
+{
+public:
+	// Each write to the file is at most this large
+	static constexpr std::size_t WRITE_SIZE = 8 * 1024 * 1024;
+	static constexpr const char* TEMP_FILE_EXTENSION = ".pe-save";
+
+private:
+	std::string path;
+	std::string contents;
+	std::size_t size = 0;
+	std::thread saveThread;
+
+	// These are only written by the thread before it is done
+	std::atomic<bool> isThreadDone = true;
+	bool wasSuccessful = false;
+	double elapsedMs = 0.0;
+
+public:
+	FileSaver() = default;
+	~FileSaver();
+	FileSaver(const FileSaver&) = delete;
+	FileSaver& operator=(const FileSaver&) = delete;
+
+	void start(const std::string& filePath, std::string&& fileContents);
+	void waitUntilFinished();
+
+	bool isFinished() const;
+	bool didSucceed() const { return wasSuccessful; }
+	std::size_t getSize() const { return size; }
+	// Time taken to write, flush and rename the file
+	double getElapsedMs() const { return elapsedMs; }
+
+private:
+	void save();
+};
+
+#endif
@@ -3,7 +3,9 @@
 #if !defined(FRAME_HPP)
 #define FRAME_HPP
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -34,6 +36,8 @@ public:
 	inline static std::vector<std::string> killRing;
 	inline static int killRingPointer = -1; // -1 when nothing in the kill ring
 	inline static DWORD lastClipboardSequenceNumber = 0;
+	// The lines of the last rectangle that was copied or killed
+	inline static std::vector<std::string> killedRectangle;
 	
 	// NOTE(fkp): Parent is only valid if this is not the toplevel
 	// frame. Children are only valid if this is not the bottommost
@@ -56,6 +60,9 @@ public:
 	Buffer* currentBuffer = nullptr;
 	Point point;
 	Point mark;	
+	// Other places that are edited along with the point. These are
+	// anchors, so they're kept on the heap to stay in one place.
+	std::vector<std::unique_ptr<Point>> cursors;
 
 	int currentTopLine = 0;
 	int targetTopLine = 0;
@@ -70,14 +77,19 @@ public:
 	unsigned int popupCurrentSuggestion = 0;
 	int popupCurrentTopLine = 0;
 	int popupTargetTopLine = 0;
-	bool shouldUpdatePopups = true;
 
-	bool shouldReLexBuffer = true;
 	bool overwriteMode = false;
 
 private:
 	inline static std::unordered_map<std::string, Frame*> framesMap;
 
+	// Point tasks and popups wait until the outermost transaction is
+	// committed, so they're only done once for a group of edits.
+	unsigned int transactionDepth = 0;
+	Buffer* transactionBuffer = nullptr;
+	bool hasPendingPointTasks = false;
+	bool hasPendingPopupUpdate = false;
+
 public:
 	Frame(std::string name, Vector4f dimensions, unsigned int windowWidth, unsigned int windowHeight, Buffer* buffer = nullptr, bool isActive = false);
 	Frame(std::string name, Vector4f dimensions, unsigned int windowWidth, unsigned int windowHeight, BufferType type, std::string bufferName, bool isActive = false);
@@ -102,9 +114,13 @@ public:
 	void deleteTextPointToMark(bool appendToKillRing = true);
 	void deleteRestOfLine();
 
-	// This is stuff that is common to all point/buffer manipulations
+	// This is stuff that is common to all point manipulations
 	void doCommonPointManipulationTasks();
-	void doCommonBufferManipulationTasks();
+
+	// Edits in between these (including in the buffer) are published
+	// together when the outermost transaction is committed.
+	void beginTransaction();
+	void commitTransaction();
 	
 	// Manipulations at the point
 	void insertChar(char character);
@@ -113,6 +129,12 @@ public:
 	void newLine();
 	void insertString(const std::string& string);
 
+	// Multiple cursors
+	void addCursor(const Point& location);
+	void clearCursors();
+	void removeDuplicateCursors();
+	std::vector<Point> getCursorLocations(); // Sorted, including the point
+
 	// Movement of the point
 	void movePointLeft(unsigned int num = 1);
 	void movePointRight(unsigned int num = 1);
@@ -127,14 +149,14 @@ public:
 	void centerPoint();
 
 	void getRect(Font* currentFont, int* realPixelX, unsigned int* realPixelWidth, int* pixelX, int* pixelY, unsigned int* pixelWidth, unsigned int* pixelHeight);
-	void getPointRect(Font* currentFont, unsigned int tabWidth, int framePixelX, int framePixelY, float* pointX, float* pointY, float* pointWidth, float* pointHeight);	
+	// This is for the point unless another location is given
+	void getPointRect(Font* currentFont, unsigned int tabWidth, int framePixelX, int framePixelY, float* pointX, float* pointY, float* pointWidth, float* pointHeight, const Point* location = nullptr);
 	Token* getTokenUnderPoint(bool includeEnd = false);
 	
 	// Utility
 	unsigned int findWordBoundaryLeft();
 	unsigned int findWordBoundaryRight();
 	void moveColToTarget();
-	void adjustOtherFramePointLocations(bool insertion, bool lineWrap);
 
 	bool warnIfBufferIsReadOnly();
 	
@@ -147,14 +169,35 @@ public:
 	void pasteClipboard();
 	void pastePop();
 
+	// Rectangles, between the columns of the point and the mark. These
+	// edit every line at once, as one step in the undo history.
+	void copyRectangle(unsigned int tabWidth, bool shouldDelete = false);
+	void yankRectangle(unsigned int tabWidth);
+	// Puts the text on every line of the rectangle, either in front of
+	// it or in place of it
+	void stringRectangle(std::string_view text, unsigned int tabWidth, bool replacesRectangle);
+
 private:
 	void init(std::string name, Vector4f dimensions, unsigned int windowWidth, unsigned int windowHeight, Buffer* buffer = nullptr, bool isActive = false);
 
+	// Puts each text in place of the rectangle on its line in one edit,
+	// and returns what was there. Point and mark go around the new text.
+	std::vector<std::string> replaceRectangle(unsigned int firstLine, unsigned int leftColumn, unsigned int rightColumn, unsigned int tabWidth, const std::vector<std::string_view>& texts);
+
+	// The point and mark follow edits while the buffer is shown
+	void addAnchors();
+	void removeAnchors();
+
+	// These do an edit at every cursor at once
+	void insertAtCursors(std::string_view text);
+	void eraseAtCursors(unsigned int numberBefore, unsigned int numberAfter);
+
 	void deleteChildFrames(Frame* otherChild); // Called from one sibling
 	void resizeChildrenToFitSize();
 };
 
 // TODO(fkp): Find a better spot for this
 void advanceToNextTabStop(unsigned int tabWidth, const Font* font, float& x, unsigned int& numberOfColumnsInLine);
+unsigned int getNumberOfColumnsToNextTabStop(unsigned int tabWidth, unsigned int numberOfColumnsInLine);
 
 #endif
@@ -0,0 +1,80 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(JOURNAL_HPP)
+#define JOURNAL_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "undo.hpp"
+
+// Records the edits made to a buffer in a file next to it, so they can
+// be recovered if the editor dies before the buffer is saved. Records
+// are only ever appended, and are relative to the file as it was on disk
+// when the journal was started.
+class Journal
+{
+public:
+	static constexpr const char* FILE_EXTENSION = ".pe-journal";
+	static constexpr char MAGIC[4] = { 'P', 'E', 'J', '1' };
+	// The size given to files that don't exist yet
+	static constexpr std::uint64_t NO_FILE = (std::uint64_t) -1;
+
+	// Used to check that a journal belongs to the file on disk
+	struct FileIdentity
+	{
+		std::uint64_t size = NO_FILE;
+		std::int64_t writeTime = 0;
+
+		bool operator==(const FileIdentity& other) const { return size == other.size && writeTime == other.writeTime; }
+	};
+
+private:
+	std::string journalPath;
+	FileIdentity baseFile;
+	std::ofstream file;
+
+	// NOTE(fkp): Records are written once per frame by flush(), a crash
+	// can only lose the edits from the last frame.
+	std::string unflushedRecords;
+	unsigned int numberOfRecords = 0;
+
+	// Records since a save started, these are still unsaved once it is done
+	bool isKeepingRecordsSinceSave = false;
+	std::string recordsSinceSave;
+	unsigned int numberOfRecordsSinceSave = 0;
+
+public:
+	static FileIdentity getFileIdentity(const std::string& filePath);
+	static std::string getJournalPath(const std::string& filePath);
+	// Returns false if there is no journal for the file, or if the file
+	// has changed since the journal was started.
+	static bool read(const std::string& filePath, std::vector<Action>& actions);
+
+	// Deletes any old journal, the next records are relative to the file
+	// as it is now. A journal that is being recovered is kept, it is only
+	// replaced once its records have been appended again and flushed.
+	void reset(const std::string& filePath, bool shouldKeepOldFile = false);
+	void discard();
+
+	void append(ActionType type, const Point& start, std::string_view text);
+	void append(const Action& action) { append(action.type, action.start, action.data); }
+	void flush();
+	bool hasRecords() const { return numberOfRecords > 0; }
+
+	void startSave();
+	// A successful save starts a new journal for the saved file that
+	// only has the edits made while saving.
+	void finishSave(const std::string& filePath, bool wasSuccessful);
+
+private:
+	// Forgets the records without touching the file
+	void close();
+	void writeVarint(std::string& output, std::uint64_t value);
+	static bool readVarint(const char*& current, const char* end, std::uint64_t& value);
+};
+
+#endif
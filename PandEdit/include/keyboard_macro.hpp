@@ -0,0 +1,53 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(KEYBOARD_MACRO_HPP)
+#define KEYBOARD_MACRO_HPP
+
+#include <string>
+#include <vector>
+
+class Window;
+class Frame;
+class Buffer;
+
+// Records the commands and typed characters between starting and ending
+// a macro. Replaying runs them straight away (without going through the
+// window or redrawing) inside one transaction on the current frame, so
+// the lexing and fix-ups are done once at the end and all of it is one
+// step in the undo history. The replay stops as soon as a step leaves
+// the buffer it started on (other than for the minibuffer).
+class KeyboardMacro
+{
+private:
+	struct Step
+	{
+		std::string commandText; // Empty for a typed character
+		bool shortcut = false;
+		char character = 0; // A '\n' is a new line
+	};
+
+	inline static std::vector<Step> steps; // Of the last macro recorded
+	inline static std::vector<Step> stepsBeingRecorded;
+
+public:
+	inline static bool isRecording = false;
+	inline static bool isReplaying = false;
+
+public:
+	static void start();
+	static bool end(bool wasEndedFromMinibuffer);
+	static unsigned int getNumberOfSteps();
+
+	static void recordCommand(const std::string& commandText, bool shortcut);
+	static void recordChar(char character);
+
+	// These return the number of steps that were run
+	static std::size_t replay(Window& window, unsigned int numberOfTimes);
+	static std::size_t replayOnLines(Window& window, unsigned int firstLine, unsigned int lastLine);
+
+private:
+	// Returns the number of steps run before leaving the buffer
+	static std::size_t runSteps(Window& window, Frame* frame, Buffer* buffer);
+};
+
+#endif
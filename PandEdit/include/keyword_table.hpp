@@ -0,0 +1,198 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(KEYWORD_TABLE_HPP)
+#define KEYWORD_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+enum class KeywordType : unsigned char
+{
+	None,
+	Keyword,
+	PrimitiveType,
+};
+
+// 1. NOTE(fkp): These are only keywords in some contexts
+inline constexpr std::string_view KEYWORDS[] = {
+	"alignas", "alignof", "sizeof", "typeid", "decltype",
+
+	"and", "and_eq", "bitand", "bitor", "compl",
+	"not", "not_eq", "or", "or_eq", "xor", "xor_eq",
+
+	"atomic_cancel", "atomic_commit", "atomic_noexcept",
+
+	"break", "case", "continue", "default", "do", "else",
+	"for", "goto", "if", "return", "switch", "while",
+
+	"const", "consteval", "constexpr", "constinit", "const_cast",
+
+	"auto", "class", "delete", "enum", "explicit", "final" /* note 1 */,
+	"friend", "inline", "mutable", "namespace", "new", "noexcept",
+	"operator", "override" /* note 1 */, "private", "protected",
+	"public", "struct", "template", "this", "typedef", "typename",
+	"union", "using", "virtual", "volatile",
+
+	"catch", "throw", "try",
+
+	"co_await", "co_return", "co_yield", "synchronized", "thread_local",
+
+	"concept", "export", "import" /* note 1 */,
+	"module" /* note 1 */, "requires",
+
+	"extern", "register", "static",
+
+	"dynamic_cast", "reinterpret_cast", "static_assert", "static_cast",
+
+	"asm", "reflexpr",
+};
+
+inline constexpr std::string_view PRIMITIVE_TYPES[] = {
+	"bool",
+	"char", "char8_t", "char16_t", "char32_t", "wchar_t",
+	"double", "float",
+	"int", "long", "short",
+	"signed", "unsigned",
+	"false", "nullptr", "true", "void",
+};
+
+// A perfect hash over the keywords and primitive types (hash and
+// displace). A word's hash picks a bucket, the bucket's seed then picks
+// the word's slot, so a lookup is two hashes of the text and a single
+// comparison, with nothing allocated.
+class KeywordTable
+{
+public:
+	static constexpr std::size_t NUMBER_OF_KEYWORDS = std::size(KEYWORDS);
+	static constexpr std::size_t NUMBER_OF_WORDS = NUMBER_OF_KEYWORDS + std::size(PRIMITIVE_TYPES);
+	static constexpr std::size_t NUMBER_OF_BUCKETS = 64;
+	static constexpr std::size_t NUMBER_OF_SLOTS = 256;
+	static constexpr std::uint8_t EMPTY_SLOT = 0xFF;
+	static constexpr std::size_t MIN_LENGTH = 2;
+	static constexpr std::size_t MAX_LENGTH = 16;
+	static_assert(NUMBER_OF_WORDS < EMPTY_SLOT, "Too many words for the keyword table.");
+
+private:
+	// NOTE(fkp): Searching for these at compile time is too slow for
+	// MSVC's constexpr step limit, so the seeds and the slots they give
+	// are written out here and only checked below. The seeds were found
+	// by trying 1 up for each bucket, biggest buckets first, until none
+	// of its words landed on a taken slot. They have to be searched for
+	// again if the words change.
+	static constexpr std::uint32_t SEEDS[NUMBER_OF_BUCKETS] = {
+		1, 0, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 2, 1,
+		1, 2, 1, 1, 1, 1, 1, 2, 1, 3, 3, 1, 1, 1, 1, 2,
+		0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 1, 1,
+		2, 1, 0, 0, 3, 1, 1, 1, 1, 2, 1, 1, 1, 3, 1, 1,
+	};
+
+	// The index of the word in each slot, or EMPTY_SLOT
+	static constexpr std::uint8_t SLOTS[NUMBER_OF_SLOTS] = {
+		255, 255, 50, 255, 255, 17, 255, 255, 255, 71, 255, 255, 255, 13, 255, 99,
+		255, 35, 255, 255, 58, 255, 255, 255, 9, 255, 95, 100, 255, 42, 46, 255,
+		14, 255, 39, 255, 255, 255, 23, 255, 0, 255, 255, 255, 255, 255, 36, 33,
+		255, 255, 255, 255, 255, 255, 255, 31, 88, 62, 255, 87, 255, 255, 255, 255,
+		255, 96, 93, 255, 3, 255, 30, 255, 255, 255, 255, 255, 255, 255, 61, 12,
+		255, 255, 255, 255, 47, 255, 6, 255, 255, 15, 24, 255, 18, 255, 44, 255,
+		255, 52, 255, 255, 51, 255, 255, 10, 255, 19, 255, 255, 89, 38, 255, 255,
+		79, 255, 255, 255, 255, 56, 255, 255, 255, 85, 255, 27, 255, 91, 255, 255,
+		16, 48, 255, 255, 255, 255, 255, 255, 255, 63, 22, 255, 82, 20, 64, 32,
+		55, 255, 26, 255, 255, 255, 90, 255, 255, 74, 57, 69, 255, 92, 255, 255,
+		255, 28, 72, 255, 255, 2, 255, 78, 45, 255, 7, 86, 41, 255, 21, 255,
+		80, 255, 255, 29, 68, 255, 4, 8, 83, 255, 37, 255, 255, 66, 255, 255,
+		53, 75, 1, 73, 255, 34, 67, 255, 255, 255, 255, 255, 255, 255, 54, 65,
+		255, 98, 255, 59, 255, 76, 255, 255, 60, 255, 255, 25, 255, 255, 40, 255,
+		255, 49, 255, 255, 255, 255, 94, 255, 255, 255, 255, 97, 255, 43, 11, 81,
+		255, 255, 255, 5, 255, 255, 255, 255, 255, 255, 70, 77, 84, 255, 255, 255,
+	};
+
+public:
+	static constexpr KeywordType classify(std::string_view text)
+	{
+		if (text.size() < MIN_LENGTH || text.size() > MAX_LENGTH)
+		{
+			return KeywordType::None;
+		}
+
+		std::uint8_t index = SLOTS[getSlot(hash(text))];
+
+		if (index == EMPTY_SLOT || getWord(index) != text)
+		{
+			return KeywordType::None;
+		}
+
+		return index < NUMBER_OF_KEYWORDS ? KeywordType::Keyword : KeywordType::PrimitiveType;
+	}
+
+	static constexpr std::string_view getWord(std::size_t index)
+	{
+		return index < NUMBER_OF_KEYWORDS ? KEYWORDS[index] : PRIMITIVE_TYPES[index - NUMBER_OF_KEYWORDS];
+	}
+
+	// Checks a few words at a time, so each check stays well under the
+	// compilers' constexpr limits.
+	static constexpr bool areWordsInTheirSlots(std::size_t firstWord, std::size_t lastWord)
+	{
+		for (std::size_t i = firstWord; i < lastWord && i < NUMBER_OF_WORDS; i++)
+		{
+			std::string_view word = getWord(i);
+
+			if (word.size() < MIN_LENGTH || word.size() > MAX_LENGTH || SLOTS[getSlot(hash(word))] != i)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+private:
+	// FNV-1a
+	static constexpr std::uint32_t hash(std::string_view text)
+	{
+		std::uint32_t result = 2166136261u;
+
+		for (char character : text)
+		{
+			result ^= (std::uint8_t) character;
+			result *= 16777619u;
+		}
+
+		return result;
+	}
+
+	// Spreads the low bits out, as only they are used to pick a bucket or slot
+	static constexpr std::uint32_t mix(std::uint32_t value)
+	{
+		value ^= value >> 16;
+		value *= 0x7FEB352Du;
+		value ^= value >> 15;
+		value *= 0x846CA68Bu;
+		value ^= value >> 16;
+
+		return value;
+	}
+
+	static constexpr std::size_t getSlot(std::uint32_t textHash)
+	{
+		std::uint32_t seed = SEEDS[mix(textHash) % NUMBER_OF_BUCKETS];
+		return mix(textHash ^ (seed * 0x9E3779B9u)) % NUMBER_OF_SLOTS;
+	}
+};
+
+static_assert(KeywordTable::areWordsInTheirSlots(0, 16), "The keyword table's seeds are out of date.");
+static_assert(KeywordTable::areWordsInTheirSlots(16, 32), "The keyword table's seeds are out of date.");
+static_assert(KeywordTable::areWordsInTheirSlots(32, 48), "The keyword table's seeds are out of date.");
+static_assert(KeywordTable::areWordsInTheirSlots(48, 64), "The keyword table's seeds are out of date.");
+static_assert(KeywordTable::areWordsInTheirSlots(64, 80), "The keyword table's seeds are out of date.");
+static_assert(KeywordTable::areWordsInTheirSlots(80, 96), "The keyword table's seeds are out of date.");
+static_assert(KeywordTable::areWordsInTheirSlots(96, KeywordTable::NUMBER_OF_WORDS), "The keyword table's seeds are out of date.");
+
+inline KeywordType classifyKeyword(std::string_view text)
+{
+	return KeywordTable::classify(text);
+}
+
+#endif
@@ -0,0 +1,18 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(LEX_SCAN_HPP)
+#define LEX_SCAN_HPP
+
+// Vectorised (AVX2 or SSE2, with a scalar fallback) scanning for the
+// lexer, to get over runs of characters it would otherwise look at one
+// at a time. These all return end if nothing is found.
+
+// The '*' of the first "*/"
+const char* findBlockCommentEnd(const char* start, const char* end);
+const char* findQuoteOrBackslash(const char* start, const char* end);
+// The first character that isn't a space or tab
+const char* skipWhitespace(const char* start, const char* end);
+// The first character that isn't [A-Za-z0-9_]
+const char* skipIdentifierCharacters(const char* start, const char* end);
+
+#endif
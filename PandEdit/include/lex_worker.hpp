@@ -0,0 +1,73 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(LEX_WORKER_HPP)
+#define LEX_WORKER_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "line_lex_state.hpp"
+#include "timer.hpp"
+
+class Buffer;
+
+// Lexes the rest of a buffer on a background thread, from a copy of
+// its text. The buffer keeps track of the edits made since the copy,
+// the results are moved along with lines added or removed before it.
+class LexWorker
+{
+public:
+	// Big copies are split into chunks that are lexed at the same time
+	static constexpr unsigned int MIN_LINES_PER_THREAD = 16 * 1024;
+
+private:
+	unsigned int firstLine = 0;
+	LineLexState::FinishType finishTypeBefore = LineLexState::FinishType::Finished;
+	std::vector<LineLexState> lineStates;
+	// Where each chunk starts, in lines of the buffer
+	std::vector<unsigned int> chunkFirstLines;
+	std::thread lexThread;
+
+	// These are only written by the thread before it is done
+	std::atomic<bool> isThreadDone = true;
+	std::atomic<bool> shouldStop = false;
+	bool wasSuccessful = false;
+	Timer timer;
+	double elapsedMs = 0.0;
+
+public:
+	LexWorker() = default;
+	~LexWorker();
+	LexWorker(const LexWorker&) = delete;
+	LexWorker& operator=(const LexWorker&) = delete;
+
+	// The text is from the line before firstLine (if there is one) to
+	// the end of the buffer, that line only gives how the one before
+	// firstLine finished.
+	void start(const Buffer* buffer, unsigned int startLine, std::string&& text, LineLexState::FinishType finishTypeBefore);
+	void stop();
+	void waitUntilFinished();
+
+	bool isFinished() const;
+	bool didSucceed() const { return wasSuccessful; }
+	unsigned int getFirstLine() const { return firstLine; }
+	const std::vector<unsigned int>& getChunkFirstLines() const { return chunkFirstLines; }
+	// How the line before firstLine finished when the text was copied
+	LineLexState::FinishType getFinishTypeBefore() const { return finishTypeBefore; }
+	double getElapsedMs() const { return elapsedMs; }
+	// Only valid once finished, the tokens are already in the buffer's lines
+	std::vector<LineLexState> takeLineStates();
+	// Only valid once finished, for lines added or removed before
+	// firstLine since the text was copied.
+	void shiftLines(int numberOfLines);
+
+private:
+	void lex(const Buffer* buffer, std::string text);
+	// Each chunk has to start the way the one before it finished
+	bool stitchChunks(std::vector<std::unique_ptr<Buffer>>& chunks);
+};
+
+#endif
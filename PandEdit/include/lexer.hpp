@@ -3,34 +3,71 @@
 #if !defined(LEXER_HPP)
 #define LEXER_HPP
 
+#include <atomic>
+#include <climits>
 #include <vector>
 #include <string>
-#include <unordered_set>
+#include <string_view>
 #include <unordered_map>
 
+#include "keyword_table.hpp"
 #include "point.hpp"
 #include "token.hpp"
 #include "line_lex_state.hpp"
 
 class Buffer;
 
+// Lines removed and then added after a line, as part of adjustLines()
+struct LineChange
+{
+	unsigned int line;
+	unsigned int numberOfLinesRemoved = 0;
+	unsigned int numberOfLinesAdded = 0;
+};
+
 class Lexer
 {
 public:
-	static std::unordered_set<std::string> keywords;
-	static std::unordered_set<std::string> primitiveTypes;
-	
 	Buffer* buffer;
 	std::vector<LineLexState> lineStates;
+	// Lexing stops as soon as this is set, for lexers on another thread
+	const std::atomic<bool>* stopFlag = nullptr;
+	// Skips over comments, strings and whitespace with lex_scan rather
+	// than a character at a time. Only turned off to check against.
+	bool isUsingVectorScanning = true;
+
+private:
+	unsigned int stopLine = UINT_MAX;
+	bool hasStoppedEarly = false;
+
+	// Every signature found for each function name, the buffer's
+	// functionDefinitions has the first one found.
+	std::unordered_map<std::string, std::vector<std::string>> functionSignatures;
 	
 public:
 	Lexer(Buffer* buffer);
 	
 	// TODO(fkp): Language of lexing
-	void lex(unsigned int startLine, bool lexEntireBuffer);
+	// lexToEnd keeps going past the point where the lines start to
+	// match their old state, without clearing the lines before startLine.
+	// Lines before lexUntilLine are always lexed. Lines after stopLine
+	// are never lexed, this returns false if there were more to lex.
+	bool lex(unsigned int startLine, bool lexEntireBuffer, bool lexToEnd = false, unsigned int lexUntilLine = 0, unsigned int stopLine = UINT_MAX);
 	void addLine(Point splitPoint);
 	void removeLine(Point newPoint);
+	// These are for many lines being added or removed at once. The
+	// lines from line until the end of the change need to be lexed again.
+	void addLines(unsigned int line, unsigned int numberOfLines);
+	void removeLines(unsigned int line, unsigned int numberOfLines);
+	// The same as doing each change from the last one back, in one pass
+	// over the lines. They have to be sorted, in lines from before any
+	// of them, and a change can only start on a line removed by the one
+	// before it if that's the last line it removes.
+	void adjustLines(const std::vector<LineChange>& changes);
 	std::vector<Token*> getTokens(unsigned int startLine, unsigned int endLine);
+	// Puts lines lexed somewhere else in place, from firstLine on. The
+	// seams are where they were lexed without the lines before them.
+	bool replaceLineStates(unsigned int firstLine, std::vector<LineLexState>&& newLineStates, const std::vector<unsigned int>& seams);
 
 private:
 	void lexString(Point& point, LineLexState::FinishType& currentLineLastFinishType);
@@ -40,12 +77,19 @@ private:
 	void lexBlockComment(Point& point, LineLexState::FinishType& currentLineLastFinishType);
 	void lexNumber(Point& point);
 	void lexPreprocessorDirective(Point& point);
-	bool lexKeyword(const Point& startPoint, const Point& point, const std::string& tokenText);
-	void lexIdentifier(const Point& startPoint, const Point& point, const std::string& tokenText);
+	bool lexKeyword(const Point& startPoint, const Point& point, std::string_view tokenText, KeywordType keywordType);
+	void lexIdentifier(const Point& startPoint, const Point& point, KeywordType keywordType);
 	bool lexPunctuation(Point& point);
 
-	void doFinalAdjustments();
-	std::unordered_map<std::string, std::string> findFunctionsInBuffer();
+	// These only go over the lines that were just lexed, so an edit
+	// doesn't cost more in a bigger file.
+	bool shouldStop(unsigned int line);
+	void doFinalAdjustments(unsigned int firstLine, unsigned int lastLine);
+	void updateFunctionDefinitions(unsigned int firstLine, unsigned int lastLine);
+	void findFunctionsInLines(unsigned int firstLine, unsigned int lastLine);
+	void addFunctionDefinitions(LineLexState& lineState);
+	void removeFunctionDefinitions(LineLexState& lineState);
+	void clearFunctionDefinitions();
 	
 	static bool isIdentifierStartCharacter(char character);
 	static bool isIdentifierCharacter(char character);
@@ -0,0 +1,58 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(LINE_ARENA_HPP)
+#define LINE_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Storage for the text of edited lines. Each line gets a block with a
+// power of two size (its size class), and small blocks are carved out
+// of large slabs. Freed blocks are kept on a list for their size class
+// and reused by the next line that needs one, so editing hardly ever
+// has to go to the heap.
+class LineArena
+{
+public:
+	static constexpr std::size_t SLAB_SIZE = 64 * 1024;
+	static constexpr std::size_t MIN_BLOCK_SIZE = 16;
+	// Blocks at least this large get a slab to themselves
+	static constexpr unsigned char FIRST_LARGE_SIZE_CLASS = 12;
+
+private:
+	std::vector<std::unique_ptr<char[]>> slabs;
+	std::vector<std::size_t> freeSlabs;
+	std::vector<std::vector<std::size_t>> freeBlocks; // One list for each size class
+
+	// New small blocks come from the end of this slab
+	std::size_t currentSlab = (std::size_t) -1;
+	std::size_t currentSlabUsed = SLAB_SIZE;
+
+	std::size_t numberOfBytesInUse = 0;
+	std::size_t numberOfBytesFree = 0;
+	std::size_t numberOfBytesReserved = 0;
+
+public:
+	// Heap allocations made for slabs, this is carried over by compaction
+	std::size_t numberOfHeapAllocations = 0;
+
+public:
+	static unsigned char getSizeClass(std::size_t size);
+	static std::size_t getBlockSize(unsigned char sizeClass);
+
+	// Blocks are identified by an offset, it stays the same until the
+	// block is freed. The pointer from getData() is valid until then.
+	std::size_t allocate(unsigned char sizeClass);
+	void free(std::size_t block, unsigned char sizeClass);
+	char* getData(std::size_t block);
+	const char* getData(std::size_t block) const;
+	void clear();
+
+	std::size_t getNumberOfBytesInUse() const { return numberOfBytesInUse; }
+	// Bytes in freed blocks that haven't been reused yet
+	std::size_t getNumberOfBytesFree() const { return numberOfBytesFree; }
+	std::size_t getNumberOfBytesReserved() const { return numberOfBytesReserved; }
+};
+
+#endif
@@ -3,6 +3,8 @@
 #if !defined(LINE_LEX_STATE_HPP)
 #define LINE_LEX_STATE_HPP
 
+#include <string>
+#include <utility>
 #include <vector>
 #include "token.hpp"
 
@@ -28,6 +30,9 @@ public:
 	
 	std::vector<Token> tokens;
 	FinishType finishType = FinishType::Finished;
+	// The name and signature of each function defined on this line,
+	// these are what the line adds to the buffer's function index.
+	std::vector<std::pair<std::string, std::string>> functionDefinitions;
 
 public:
 	// NOTE(fkp): Use ExcludableToken for the excludes
@@ -0,0 +1,13 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(NEWLINE_SCAN_HPP)
+#define NEWLINE_SCAN_HPP
+
+#include <cstddef>
+
+// Vectorised (AVX2 or SSE2, with a scalar fallback) scanning for line
+// breaks in large blocks of text, such as a file that was just read.
+const char* findNewline(const char* start, const char* end);
+std::size_t countNewlines(const char* start, const char* end);
+
+#endif
@@ -0,0 +1,78 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(PAGED_FILE_HPP)
+#define PAGED_FILE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reads parts of a file that is too large to keep in memory. A sparse
+// index of line offsets (one checkpoint every LINES_PER_CHECKPOINT
+// lines) is built on a background thread, but nothing here has to wait
+// for it unless it needs an absolute line number.
+class PagedFile
+{
+public:
+	static constexpr unsigned int LINES_PER_CHECKPOINT = 4096;
+	static constexpr std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+private:
+	std::string path;
+	std::uint64_t fileSize = 0;
+	bool doesEndWithNewline = true;
+	std::ifstream file;
+	// Reused by all the reads on the main thread, they run on every
+	// scroll of a paged buffer.
+	std::vector<char> readBuffer;
+
+	// checkpoints[i] is the offset of line (i * LINES_PER_CHECKPOINT)
+	std::vector<std::uint64_t> checkpoints;
+	mutable std::mutex checkpointsMutex;
+	std::atomic<std::uint64_t> numberOfBytesIndexed = 0;
+	std::atomic<std::uint64_t> numberOfNewlines = 0;
+	std::atomic<bool> isIndexingDone = false;
+	std::atomic<bool> shouldStopIndexing = false;
+	std::thread indexThread;
+
+public:
+	PagedFile() = default;
+	~PagedFile();
+	PagedFile(const PagedFile&) = delete;
+	PagedFile& operator=(const PagedFile&) = delete;
+
+	bool open(const std::string& filePath);
+	void close();
+
+	std::uint64_t getSize() const { return fileSize; }
+	bool isIndexComplete() const;
+	double getIndexProgress() const;
+	// Counts lines the same way as a normally loaded buffer. This is
+	// only valid once the index is complete.
+	std::uint64_t getNumberOfLines() const;
+
+	// Reads up to maxNumberOfLines whole lines (including their line
+	// endings), starting with the line that starts at startOffset.
+	std::string readLines(std::uint64_t startOffset, unsigned int maxNumberOfLines, std::vector<std::uint64_t>& lineOffsets, std::uint64_t& endOffset);
+	// Walks back from the start of a line, returns how many lines were
+	// actually passed (fewer at the start of the file).
+	unsigned int findStartOfPreviousLines(std::uint64_t lineStartOffset, unsigned int numberOfLines, std::uint64_t& startOffset);
+	// Searches forward from startOffset, also gives the number of
+	// newlines passed on the way and the start of the line the match is
+	// on. lineStartOffset should start as the start of the line that
+	// startOffset is on.
+	bool find(std::uint64_t startOffset, const std::string& text, std::uint64_t& foundOffset, std::uint64_t& lineStartOffset, std::uint64_t& numberOfNewlinesPassed);
+	// Returns false if the index hasn't got that far yet
+	bool getLineAtOffset(std::uint64_t lineStartOffset, std::uint64_t& line);
+
+private:
+	void buildIndex();
+	std::size_t readAt(std::ifstream& stream, std::uint64_t offset, char* destination, std::size_t size);
+	char* getReadBuffer(std::size_t size);
+};
+
+#endif
@@ -0,0 +1,179 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(PIECE_TABLE_HPP)
+#define PIECE_TABLE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "file_mapping.hpp"
+#include "line_arena.hpp"
+
+// A read-only view of a single line in a piece table. Views are only
+// valid until the next modification of the table.
+class LineView : public std::string_view
+{
+public:
+	LineView() = default;
+	LineView(const char* data, size_type size)
+		: std::string_view(data, size)
+	{
+	}
+
+	// NOTE(fkp): Indexing one past the end returns '\0' (like
+	// std::string does), a lot of the lexer relies on this.
+	char operator[](size_type index) const
+	{
+		return index < size() ? data()[index] : '\0';
+	}
+
+	std::string str() const
+	{
+		return std::string(data(), size());
+	}
+};
+
+// Stores the text of a buffer as a list of lines. Each line is a piece
+// that points either into the original file contents (which are never
+// modified, and may be a mapping of the file) or to its own block in a
+// line arena once it has been edited. The pieces are kept in an
+// implicit treap so lines can be inserted and removed anywhere in
+// O(log n).
+class PieceTable
+{
+	enum class Source : unsigned char
+	{
+		Original,
+		Added,
+	};
+
+	struct Piece
+	{
+		Source source = Source::Original;
+		unsigned char sizeClass = 0; // Of the arena block, for added text
+		std::size_t start = 0; // Offset into the original, or an arena block
+		std::size_t length = 0;
+	};
+
+	struct Node
+	{
+		Piece piece;
+		unsigned int priority = 0;
+		int left = -1;
+		int right = -1;
+		unsigned int numberOfLines = 1; // Including the children
+		std::size_t numberOfChars = 1; // Including the children, counts a newline after every line
+	};
+
+private:
+	// Only one of these is used for the original contents
+	std::string original;
+	FileMapping mapping;
+	LineArena arena;
+	unsigned int numberOfEdits = 0;
+
+	std::vector<Node> nodes;
+	std::vector<int> freeNodes;
+	int root = -1;
+
+	unsigned int randomState = 0x9E3779B9;
+
+	// The lexer and renderer tend to access the same line many times
+	// in a row, so the last lookup is cached.
+	mutable unsigned int cachedLine = (unsigned int) -1;
+	mutable int cachedNode = -1;
+
+public:
+	PieceTable() = default;
+
+	// Replaces the whole table with the lines in the string. Lines are
+	// separated by '\n', a '\r' before the '\n' is not included.
+	void loadFromString(std::string&& contents);
+	// Unedited lines will point straight into the mapping
+	void loadFromMapping(FileMapping&& fileMapping);
+	void clear();
+
+	bool isMapped() const;
+	// Copies the mapped contents into memory so the file can be closed
+	void detachFromMapping();
+
+	unsigned int size() const;
+	LineView operator[](unsigned int line) const;
+
+	// Character offsets count one newline between each line. These
+	// are O(log n), the counts are kept up to date in the tree.
+	std::size_t getNumberOfChars() const;
+	std::size_t getOffsetOfLine(unsigned int line) const;
+	unsigned int getLineAtOffset(std::size_t offset, std::size_t& lineStartOffset) const;
+
+	// Whole line operations
+	void insertLine(unsigned int line, std::string_view text);
+	void appendLine(std::string_view text);
+	// Inserts each line of text (which should end with a newline)
+	// before line. This is for adding more of the file while loading.
+	void insertLines(unsigned int line, std::string_view text);
+	void eraseLine(unsigned int line);
+	// Inserts the newline separated lines of text before line, and
+	// erases count lines starting at line. Both splice the whole range
+	// into the tree at once.
+	void spliceLines(unsigned int line, std::string_view text);
+	void eraseLines(unsigned int line, unsigned int count);
+	void setLine(unsigned int line, std::string_view text);
+
+	// Operations within a line (text should not contain newlines)
+	void insertText(unsigned int line, unsigned int col, std::string_view text);
+	void insertChar(unsigned int line, unsigned int col, char character);
+	void overwriteChar(unsigned int line, unsigned int col, char character);
+	void eraseText(unsigned int line, unsigned int col, unsigned int count);
+
+	// Moves everything after col onto a new line after this one
+	void splitLine(unsigned int line, unsigned int col);
+	// Appends the next line onto the end of this one
+	void joinLines(unsigned int line);
+
+	// Moves all the edited lines into new, tightly packed blocks. This
+	// invalidates all line views.
+	bool shouldCompact() const;
+	void compact();
+
+	unsigned int getNumberOfEdits() const { return numberOfEdits; }
+	const LineArena& getArena() const { return arena; }
+
+	// Rebuilds the original contents with only one copy of each distinct
+	// line, and points every unedited line at its copy. The copies are
+	// never modified, editing a line moves it into the arena. Returns
+	// the number of distinct lines.
+	unsigned int internLines();
+	// How much text the unedited lines have in total, and how much is
+	// actually stored for them.
+	void getOriginalTextSizes(std::size_t& referencedSize, std::size_t& storedSize) const;
+
+private:
+	void buildLines(bool addEmptyLastLine);
+	void allocateLines(std::size_t start, std::size_t end, std::vector<int>& lineNodes);
+	int buildTree(const std::vector<int>& lineNodes);
+	const char* getOriginalData() const;
+	std::size_t getOriginalSize() const;
+	const char* getPieceData(const Piece& piece) const;
+	int findNode(unsigned int line) const;
+	Piece makePiece(std::string_view text);
+	Piece& makeLineWritable(unsigned int line, std::size_t capacity);
+	bool isInBlock(const Piece& piece, const char* pointer) const;
+
+	int allocateNode(Piece piece);
+	void freeNode(int node);
+	unsigned int getNumberOfLines(int node) const;
+	std::size_t getNumberOfChars(int node) const;
+	void changeLineLength(unsigned int line, std::ptrdiff_t change);
+	template<typename Function>
+	void forEachNode(int subtree, Function function) const;
+	void update(int node);
+	void split(int node, unsigned int numberOfLinesLeft, int& left, int& right);
+	int merge(int left, int right);
+	unsigned int nextRandom();
+	void invalidateCache();
+};
+
+#endif
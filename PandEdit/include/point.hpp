@@ -38,6 +38,9 @@ public:
 	Point& moveNext(bool force = false);
 	Point& movePrevious();
 	unsigned int distanceTo(const Point& other) const;
+
+private:
+	bool canUseOffsets();
 };
 
 #endif
@@ -0,0 +1,31 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(RECTANGLE_HPP)
+#define RECTANGLE_HPP
+
+#include <string>
+#include <string_view>
+
+// A rectangle is the block of visual columns between the point and the
+// mark, on every line between them. Tabs are as wide as they are drawn.
+
+// Where a rectangle crosses one line
+struct RectangleSlice
+{
+	// The characters the rectangle covers (or touches, for a tab it
+	// splits), a short line has both at its end.
+	unsigned int startCol = 0;
+	unsigned int endCol = 0;
+	// Spaces that have to be kept in front of the rectangle to keep it
+	// in its column, for a short line or a tab split by its left edge
+	unsigned int paddingBefore = 0;
+	// Spaces left over from a tab split by the right edge
+	unsigned int paddingAfter = 0;
+	// What the rectangle covers, with tabs as spaces
+	std::string text;
+};
+
+unsigned int getVisualColumn(std::string_view line, unsigned int col, unsigned int tabWidth);
+RectangleSlice sliceRectangle(std::string_view line, unsigned int leftColumn, unsigned int rightColumn, unsigned int tabWidth);
+
+#endif
@@ -0,0 +1,25 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(REGION_TRANSFORMS_HPP)
+#define REGION_TRANSFORMS_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// These work on the lines of a region as views into one copy of its
+// text, so the buffer only has to replace the region once at the end.
+std::vector<std::string_view> splitIntoLines(std::string_view text);
+std::string joinWithNewlines(const std::vector<std::string_view>& lines);
+
+// Big regions are sorted in chunks on several threads and merged
+void sortLines(std::vector<std::string_view>& lines);
+// Keeps the first of each line
+void uniqueLines(std::vector<std::string_view>& lines);
+void reverseLines(std::vector<std::string_view>& lines);
+void trimTrailingWhitespace(std::vector<std::string_view>& lines);
+// Pads the first delimiter in each line out to the same column. The
+// padded lines are kept in alignedLines, which the views point into.
+void alignLines(std::vector<std::string_view>& lines, std::string_view delimiter, std::vector<std::string>& alignedLines);
+
+#endif
@@ -0,0 +1,30 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(RUN_ON_THREADS_HPP)
+#define RUN_ON_THREADS_HPP
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Calls the function with each index from 0 to numberOfThreads - 1 at
+// the same time, index 0 runs on the calling thread.
+template<typename Function>
+void runOnThreads(std::size_t numberOfThreads, Function function)
+{
+	std::vector<std::thread> threads;
+
+	for (std::size_t i = 1; i < numberOfThreads; i++)
+	{
+		threads.emplace_back(function, i);
+	}
+
+	function(0);
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+#endif
@@ -0,0 +1,84 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(SHELL_FILTER_HPP)
+#define SHELL_FILTER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+#include "point.hpp"
+#include "timer.hpp"
+
+// Runs text through a shell command. The text is streamed into the
+// command's STDIN on one thread while its STDOUT is read back on
+// another (doing both on one thread can deadlock once a pipe fills up),
+// so the editor carries on while it runs.
+class ShellFilter
+{
+public:
+	// Each write to the command's STDIN is at most this large
+	static constexpr std::size_t WRITE_SIZE = 64 * 1024;
+	static constexpr std::size_t READ_SIZE = 64 * 1024;
+
+	// The region being filtered, these are anchors in the buffer so they
+	// follow any edits made while the command runs.
+	Point regionStart;
+	Point regionEnd;
+
+private:
+	std::string command;
+	std::string input;
+	std::string output;
+	std::thread writeThread;
+	std::thread readThread;
+
+	// NOTE(fkp): These are HANDLEs, <windows.h> can't be included here.
+	// Each pipe belongs to its thread, which is the only thing that
+	// closes it.
+	void* process = nullptr;
+	void* job = nullptr;
+	void* stdInWrite = nullptr;
+	void* stdOutRead = nullptr;
+
+	// These are only written by the threads before they are done
+	std::atomic<bool> isReadThreadDone = true;
+	std::atomic<bool> wasCancelled = false;
+	std::atomic<std::size_t> numberOfBytesWritten = 0;
+	std::atomic<std::size_t> numberOfBytesRead = 0;
+	unsigned long exitCode = 0;
+	bool didExit = false;
+	Timer timer;
+	double elapsedMs = 0.0;
+
+public:
+	ShellFilter() = default;
+	~ShellFilter();
+	ShellFilter(const ShellFilter&) = delete;
+	ShellFilter& operator=(const ShellFilter&) = delete;
+
+	bool start(const std::string& shellCommand, std::string&& text);
+	// Kills the command and everything it started, and stops both threads
+	void cancel();
+	void waitUntilFinished();
+
+	bool isFinished() const;
+	bool isCancelled() const { return wasCancelled; }
+	bool didSucceed() const { return didExit && exitCode == 0; }
+	unsigned long getExitCode() const { return exitCode; }
+	const std::string& getCommand() const { return command; }
+	std::size_t getInputSize() const { return input.size(); }
+	std::size_t getNumberOfBytesWritten() const { return numberOfBytesWritten; }
+	std::size_t getNumberOfBytesRead() const { return numberOfBytesRead; }
+	double getElapsedMs() const { return elapsedMs; }
+	// Only valid once finished
+	std::string takeOutput();
+
+private:
+	void write();
+	void read();
+	static void closePipe(void*& pipe);
+};
+
+#endif
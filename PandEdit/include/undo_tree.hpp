@@ -0,0 +1,116 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if !defined(UNDO_TREE_HPP)
+#define UNDO_TREE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "line_arena.hpp"
+#include "point.hpp"
+#include "undo.hpp"
+
+// Every action made to a buffer. Making a new action after undoing
+// doesn't throw away the ones that were undone, it starts a new branch
+// from the current action instead. The text of each action lives in an
+// arena, and once that gets bigger than the memory budget the oldest
+// actions are compressed, and after that moved out to a file on disk.
+class UndoTree
+{
+public:
+	inline static std::size_t memoryBudget = 16 * 1024 * 1024;
+	// Actions this close to the newest one are left alone by the budget
+	static constexpr unsigned int NUMBER_OF_RECENT_ACTIONS = 64;
+
+	struct Stats
+	{
+		unsigned int depth = 0; // Number of actions that can be undone
+		unsigned int numberOfActions = 0;
+		unsigned int numberOfBranches = 0; // Actions with more than one child
+		std::size_t numberOfBytesInMemory = 0;
+		unsigned int numberOfCompressedActions = 0;
+		unsigned int numberOfSpilledActions = 0;
+		std::uint64_t numberOfBytesSpilled = 0;
+	};
+
+private:
+	struct Node
+	{
+		ActionType type = ActionType::Insertion;
+		bool isCompressed = false;
+		bool isSpilled = false;
+		bool continuesGroup = false; // Undone and redone along with its parent
+		unsigned char sizeClass = 0;
+
+		unsigned int startLine = 0;
+		unsigned int startCol = 0;
+		unsigned int endLine = 0;
+		unsigned int endCol = 0;
+
+		int parent = -1;
+		int firstChild = -1;
+		int nextSibling = -1;
+		int redoChild = -1; // The child that redo goes to
+		unsigned int depth = 0;
+
+		// An arena block, or an offset into the spill file
+		std::uint64_t payload = 0;
+		std::uint32_t storedSize = 0;
+		std::uint32_t textSize = 0;
+	};
+
+	// nodes[0] is the state before any actions
+	std::vector<Node> nodes;
+	int current = 0;
+	LineArena arena;
+
+	// Everything before these has been compressed/spilled (or skipped)
+	std::size_t nextNodeToCompress = 1;
+	std::size_t nextNodeToSpill = 1;
+
+	std::string spillPath;
+	std::fstream spillFile;
+	std::uint64_t spillFileSize = 0;
+	bool canSpill = true; // Stops trying after something goes wrong
+	unsigned int numberOfCompressedActions = 0;
+	unsigned int numberOfSpilledActions = 0;
+
+public:
+	UndoTree();
+	~UndoTree();
+	UndoTree(const UndoTree&) = delete;
+	UndoTree& operator=(const UndoTree&) = delete;
+
+	void clear();
+	// Actions that continue a group (the edits in one transaction) are
+	// undone and redone together with the one before them.
+	void add(ActionType type, const Point& start, const Point& end, std::string_view text, bool continuesGroup = false);
+
+	// The current action can only be added onto if it is the newest
+	// thing on its branch.
+	bool canAppendToCurrent(ActionType type) const;
+	void appendToCurrent(std::string_view text, const Point& newEnd);
+	Point getCurrentStart() const;
+	Point getCurrentEnd() const;
+
+	// These give the actions in the group to undo or redo, in the order
+	// they should be applied.
+	bool undo(std::vector<Action>& actions);
+	bool redo(std::vector<Action>& actions);
+	// Makes redo go down the next branch, returns the number of branches
+	unsigned int switchBranch(unsigned int& branchIndex);
+
+	Stats getStats() const;
+
+private:
+	void storeText(Node& node, std::string_view text);
+	std::string loadText(const Node& node);
+	void fillAction(const Node& node, Action& action);
+	void enforceMemoryBudget();
+	bool openSpillFile();
+};
+
+#endif
@@ -0,0 +1,162 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+#include <climits>
+
+#include "anchor_set.hpp"
+
+void AnchorSet::add(Point* point, AnchorGravity gravity)
+{
+	anchors.push_back({ point, gravity });
+}
+
+void AnchorSet::remove(Point* point)
+{
+	anchors.erase(std::remove_if(anchors.begin(), anchors.end(), [point](const Anchor& anchor)
+								 {
+									 return anchor.point == point;
+								 }), anchors.end());
+}
+
+void AnchorSet::remove(std::vector<Point*> points)
+{
+	std::sort(points.begin(), points.end());
+	anchors.erase(std::remove_if(anchors.begin(), anchors.end(), [&points](const Anchor& anchor)
+								 {
+									 return std::binary_search(points.begin(), points.end(), anchor.point);
+								 }), anchors.end());
+}
+
+void AnchorSet::moveForInsertion(const Point& start, const Point& end)
+{
+	for (Anchor& anchor : anchors)
+	{
+		Point& point = *anchor.point;
+
+		// NOTE(fkp): Point's == also compares the target col
+		if (point < start || (!(start < point) && anchor.gravity == AnchorGravity::Left))
+		{
+			continue;
+		}
+
+		if (point.line == start.line)
+		{
+			point.col = end.col + (point.col - start.col);
+		}
+
+		point.line += end.line - start.line;
+	}
+}
+
+void AnchorSet::moveForDeletion(const Point& start, const Point& end)
+{
+	for (Anchor& anchor : anchors)
+	{
+		Point& point = *anchor.point;
+
+		if (!(start < point))
+		{
+			continue;
+		}
+
+		if (!(end < point))
+		{
+			point.line = start.line;
+			point.col = start.col;
+		}
+		else
+		{
+			if (point.line == end.line)
+			{
+				point.col = start.col + (point.col - end.col);
+			}
+
+			point.line -= end.line - start.line;
+		}
+	}
+}
+
+void AnchorSet::moveForEdits(const std::vector<Edit>& edits)
+{
+	if (edits.size() == 0)
+	{
+		return;
+	}
+
+	// The anchors are swept in order along with the edits
+	std::vector<Anchor*> sortedAnchors;
+	sortedAnchors.reserve(anchors.size());
+
+	for (Anchor& anchor : anchors)
+	{
+		sortedAnchors.push_back(&anchor);
+	}
+
+	std::sort(sortedAnchors.begin(), sortedAnchors.end(), [](const Anchor* first, const Anchor* second)
+			  {
+				  return *first->point < *second->point;
+			  });
+
+	// How positions after the edits so far have moved. Only the rest of
+	// the line the last edit ended on moves sideways.
+	long long lineOffset = 0;
+	unsigned int lastEditEndLine = UINT_MAX;
+	long long colOffset = 0;
+
+	auto movePoint = [&](Point& point)
+	{
+		if (point.line == lastEditEndLine)
+		{
+			point.col = (unsigned int) (point.col + colOffset);
+		}
+
+		point.line = (unsigned int) (point.line + lineOffset);
+	};
+
+	std::size_t anchorIndex = 0;
+
+	for (const Edit& edit : edits)
+	{
+		Point newStart = edit.start;
+		movePoint(newStart);
+
+		Point newEnd = newStart;
+		newEnd.line += edit.numberOfNewlines;
+		newEnd.col = edit.numberOfNewlines == 0 ? newStart.col + edit.lastLineSize : edit.lastLineSize;
+
+		for (; anchorIndex < sortedAnchors.size(); anchorIndex++)
+		{
+			Anchor& anchor = *sortedAnchors[anchorIndex];
+			Point& point = *anchor.point;
+
+			if (point < edit.start)
+			{
+				movePoint(point);
+			}
+			else if (!(edit.start < point) && anchor.gravity == AnchorGravity::Left)
+			{
+				point.line = newStart.line;
+				point.col = newStart.col;
+			}
+			else if (!(edit.end < point))
+			{
+				// Right at an insertion, or inside a deletion
+				point.line = newEnd.line;
+				point.col = newEnd.col;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		lineOffset += (long long) edit.numberOfNewlines - (long long) (edit.end.line - edit.start.line);
+		lastEditEndLine = edit.end.line;
+		colOffset = (long long) newEnd.col - (long long) edit.end.col;
+	}
+
+	for (; anchorIndex < sortedAnchors.size(); anchorIndex++)
+	{
+		movePoint(*sortedAnchors[anchorIndex]->point);
+	}
+}
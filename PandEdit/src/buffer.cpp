@@ -3,33 +3,58 @@
 #include <fstream>
 #include <unordered_set>
 #include <algorithm>
+#include <iterator>
 
 #include "buffer.hpp"
 #include "frame.hpp"
 #include "file_util.hpp"
 #include "common.hpp"
 #include "commands.hpp"
+#include "newline_scan.hpp"
 
-Buffer::Buffer(BufferType type, std::string name, std::string path)
-	: type(type), name(name), path(path), lexer(this)
+Buffer::Buffer(BufferType type, std::string name, std::string path, FileOpenMode openMode)
+	: type(type), name(name), path(path), openMode(openMode), lexer(this)
 {
+	anchors.add(&lastPoint, AnchorGravity::Right);
+
+	// NOTE(fkp): This has to be read first, reverting deletes it
+	std::vector<Action> recoveredActions;
+	bool hasJournal = path != "" && Journal::read(path, recoveredActions);
+	
 	if (path == "" || !doesFileExist(path.c_str()))
 	{
 		// Makes sure there's at least one line in the buffer
-		data.emplace_back();
+		data.appendLine("");
+
+		if (path != "")
+		{
+			journal.reset(path);
+		}
 	}
 	else
 	{
 		// This method does all the necessary initialisation of the data
-		revertToFile();		
+		revertToFile(hasJournal);
+	}
+
+	if (hasJournal && !isPaged())
+	{
+		recoverFromJournal(recoveredActions);
 	}
 	
-	buffersMap.insert({ name, this });
+	// NOTE(fkp): Snapshots are used on other threads
+	if (type != BufferType::Snapshot)
+	{
+		buffersMap.insert({ name, this });
+	}
 }
 
 Buffer::~Buffer()
 {
-	if (name == "*scratch*")
+	finishSaving();
+	journal.discard();
+
+	if (name == "*scratch*" || type == BufferType::Snapshot)
 	{
 		return;
 	}
@@ -49,9 +74,32 @@ Buffer::~Buffer()
 
 Buffer::Buffer(Buffer&& other)
 	: type(other.type), name(std::move(other.name)), data(std::move(other.data)),
-	  lexer(other.lexer),
+	  openMode(other.openMode), pagedFile(std::move(other.pagedFile)),
+	  pagedLineOffsets(std::move(other.pagedLineOffsets)), pagedEndOffset(other.pagedEndOffset),
+	  firstPagedLine(other.firstPagedLine), isFirstPagedLineKnown(other.isFirstPagedLineKnown),
+	  loader(std::move(other.loader)), numberOfLoadedLines(other.numberOfLoadedLines),
+	  saver(std::move(other.saver)), numberOfActionsBeingSaved(other.numberOfActionsBeingSaved),
+	  numberOfEditsBeingSaved(other.numberOfEditsBeingSaved),
+	  shellFilter(std::move(other.shellFilter)),
+	  journal(std::move(other.journal)), isInterningLines(other.isInterningLines),
+	  lexer(other.lexer), isUsingSyntaxHighlighting(other.isUsingSyntaxHighlighting),
+	  functionDefinitions(std::move(other.functionDefinitions)),
+	  firstLineToLexInBackground(other.firstLineToLexInBackground),
 	  lastPoint(other.lastPoint), lastTopLine(other.lastTopLine)
 {
+	// NOTE(fkp): The lexer keeps the function index of this buffer
+	lexer.buffer = this;
+
+	// NOTE(fkp): The frames still have their anchors in the other one
+	anchors.add(&lastPoint, AnchorGravity::Right);
+
+	if (shellFilter)
+	{
+		other.anchors.remove({ &shellFilter->regionStart, &shellFilter->regionEnd });
+		anchors.add(&shellFilter->regionStart, AnchorGravity::Right);
+		anchors.add(&shellFilter->regionEnd, AnchorGravity::Left);
+	}
+
 	buffersMap[name] = this;
 	other.name = "";
 }
@@ -63,11 +111,47 @@ Buffer& Buffer::operator=(Buffer&& other)
 		type = other.type;
 		name = std::move(other.name);
 		data = std::move(other.data);
+		openMode = other.openMode;
+		pagedFile = std::move(other.pagedFile);
+		pagedLineOffsets = std::move(other.pagedLineOffsets);
+		pagedEndOffset = other.pagedEndOffset;
+		firstPagedLine = other.firstPagedLine;
+		isFirstPagedLineKnown = other.isFirstPagedLineKnown;
+		loader = std::move(other.loader);
+		numberOfLoadedLines = other.numberOfLoadedLines;
+		saver = std::move(other.saver);
+		numberOfActionsBeingSaved = other.numberOfActionsBeingSaved;
+		numberOfEditsBeingSaved = other.numberOfEditsBeingSaved;
+
+		if (shellFilter)
+		{
+			anchors.remove({ &shellFilter->regionStart, &shellFilter->regionEnd });
+		}
+
+		shellFilter = std::move(other.shellFilter);
+
+		if (shellFilter)
+		{
+			other.anchors.remove({ &shellFilter->regionStart, &shellFilter->regionEnd });
+			anchors.add(&shellFilter->regionStart, AnchorGravity::Right);
+			anchors.add(&shellFilter->regionEnd, AnchorGravity::Left);
+		}
+
+		journal = std::move(other.journal);
+		isInterningLines = other.isInterningLines;
 
 		lastPoint = other.lastPoint;
 		lastTopLine = other.lastTopLine;
 
 		lexer = other.lexer;
+		lexer.buffer = this;
+		isUsingSyntaxHighlighting = other.isUsingSyntaxHighlighting;
+		functionDefinitions = std::move(other.functionDefinitions);
+
+		// NOTE(fkp): The worker's tokens would point at the other buffer,
+		// it's started again from the same line on the next update.
+		lexWorker.reset();
+		firstLineToLexInBackground = other.firstLineToLexInBackground;
 
 		buffersMap[name] = this;
 		other.name = "";
@@ -104,301 +188,1629 @@ Buffer* Buffer::getFromFilePath(const std::string& path)
 	return nullptr;
 }
 
-void Buffer::addActionToUndoBuffer(Action&& action)
+void Buffer::update()
 {
-	if (!shouldAddToUndoInformation) return;
-	
-	if (undoInformationPointer < undoInformation.size())
+	updateLoading();
+	updateSaving();
+	updateShellFilter();
+	updateBackgroundLexing();
+	journal.flush();
+
+	if (data.getNumberOfEdits() != numberOfEditsAtLastUpdate)
 	{
-		undoInformation.erase(undoInformation.begin() + undoInformationPointer, undoInformation.end());
+		numberOfEditsAtLastUpdate = data.getNumberOfEdits();
+		timeSinceLastEdit.reset();
 	}
-
-	// Appending to the last insertion
-	if (action.type == ActionType::Insertion &&
-		undoInformation.size() > 0 && undoInformation.back().type == ActionType::Insertion &&
-		action.data.size() == 1)
+	else if (timeSinceLastEdit.getElapsedMs() > COMPACT_AFTER_IDLE_MS && data.shouldCompact())
 	{
-		Action& lastAction = undoInformation.back();
+		data.compact();
+	}
+}
 
-		// TODO(fkp): This is is a little unwieldy
-		if (lastAction.end.line == lastAction.start.line &&
-			lastAction.end.col - lastAction.start.col < 16 &&
-			lastAction.end.col > 0 && lastAction.end.col <= data[lastAction.end.line].size() &&
-			data[lastAction.end.line][lastAction.end.col - 1] != ' ' &&
-			data[lastAction.end.line][lastAction.end.col - 1] != '\t' &&
-			lastAction.end.col - 1 != data[lastAction.end.line].size())
-		{
-			if (action.data[0] == '\n')
-			{
-				lastAction.end.line += 1;
-				lastAction.end.col = 0;
-			}
-			else
-			{
-				lastAction.end.col += 1;
-			}
-			
-			lastAction.data += action.data;
-			return;
-		}
+void Buffer::beginTransaction(bool shouldRecordUndo)
+{
+	if (openTransactions.size() == 0)
+	{
+		hasStartedUndoGroup = false;
 	}
 
-	if (undoInformation.size() >= 64)
+	openTransactions.push_back(shouldRecordUndo);
+
+	if (!shouldRecordUndo)
 	{
-		undoInformation.pop_front();
+		numberOfTransactionsNotRecordingUndo += 1;
 	}
-	
-	undoInformation.push_back(std::move(action));
-	undoInformationPointer = undoInformation.size();
-	numberOfActionsSinceSave += 1;
 }
 
-bool Buffer::undo(Frame& frame)
+void Buffer::commitTransaction()
 {
-	if (undoInformationPointer == 0 || undoInformation.size() == 0)
+	if (openTransactions.size() == 0)
 	{
-		return false;
+		ERROR_ONCE("Error: Committing a transaction that was never started.\n");
+		return;
 	}
 
-	shouldAddToUndoInformation = false;
-	undoInformationPointer -= 1;
-	numberOfActionsSinceSave -= 1;
-	const Action& action = undoInformation[undoInformationPointer];
+	if (!openTransactions.back())
+	{
+		numberOfTransactionsNotRecordingUndo -= 1;
+	}
 
-	switch (action.type)
+	openTransactions.pop_back();
+
+	if (openTransactions.size() == 0 && firstLineToLex <= lastLineToLex)
 	{
-	case ActionType::Insertion:
+		unsigned int firstLine = firstLineToLex;
+		unsigned int lastLine = lastLineToLex;
+		firstLineToLex = UINT_MAX;
+		lastLineToLex = 0;
+
+		lexLines(firstLine, std::min(lastLine, data.size() - 1));
+	}
+}
+
+bool Buffer::isInTransaction() const
+{
+	return openTransactions.size() > 0;
+}
+
+void Buffer::lexLines(unsigned int firstLine, unsigned int lastLine)
+{
+	// Only edits to the lines the worker copied make it wrong
+	if (lexWorker && lastLine >= getBackgroundLexFirstLine())
 	{
-		frame.point = action.end;
+		discardBackgroundLex();
+	}
 
-		while (frame.point > action.start)
-		{
-			frame.backspaceChar();
-		}
-	} break;
+	if (!isUsingSyntaxHighlighting)
+	{
+		return;
+	}
 
-	case ActionType::Deletion:
+	if (isInTransaction())
 	{
-		frame.point = action.start;
-		frame.insertString(action.data);
-		frame.point = action.end;
-	} break;
+		firstLineToLex = std::min(firstLineToLex, firstLine);
+		lastLineToLex = std::max(lastLineToLex, lastLine);
+
+		return;
 	}
 
-	shouldAddToUndoInformation = true;
-	return true;
+	unsigned int stopLine = lastLine + FOREGROUND_LEX_NUMBER_OF_LINES;
+
+	if (!lexer.lex(firstLine, false, false, lastLine, stopLine))
+	{
+		lexInBackground(stopLine + 1);
+	}
 }
 
-// NOTE(fkp): This is basically the exact opposite to undo()
-bool Buffer::redo(Frame& frame)
+void Buffer::lexWholeBuffer()
 {
-	if (undoInformationPointer == undoInformation.size())
+	discardBackgroundLex();
+
+	if (!lexer.lex(0, true, false, 0, FOREGROUND_LEX_NUMBER_OF_LINES))
 	{
-		return false;
+		lexInBackground(FOREGROUND_LEX_NUMBER_OF_LINES + 1);
 	}
+}
 
-	shouldAddToUndoInformation = false;
-	const Action& action = undoInformation[undoInformationPointer];
+void Buffer::lexInBackground(unsigned int firstLine)
+{
+	// The worker is started on the next update, so it gets a copy of
+	// the lines after all the edits made before then.
+	firstLineToLexInBackground = std::min(firstLineToLexInBackground, firstLine);
 
-	switch (action.type)
-	{
-	case ActionType::Insertion:
+	// The lines in between aren't lexed, so the worker could have
+	// started the copy the wrong way.
+	if (lexWorker && firstLine < getBackgroundLexFirstLine())
 	{
-		frame.point = action.start;
-		frame.insertString(action.data);
-		frame.point = action.end;
-	} break;
+		discardBackgroundLex();
+	}
+}
 
-	case ActionType::Deletion:
+void Buffer::updateBackgroundLexing()
+{
+	if (lexWorker && lexWorker->isFinished())
 	{
-		frame.point = action.end;
+		// NOTE(fkp): Edits before the copy only moved its lines. It's
+		// still right as long as the line before it finishes the same
+		// way, otherwise the lines are started again from where they
+		// need to be.
+		unsigned int firstLine = getBackgroundLexFirstLine();
+		bool isStillValid = lexWorker->didSucceed() && !isBackgroundLexStale && firstLine <= lexer.lineStates.size() &&
+							(firstLine == 0 || lexer.lineStates[firstLine - 1].finishType == lexWorker->getFinishTypeBefore());
 
-		while (frame.point > action.start)
+		if (isStillValid)
 		{
-			frame.backspaceChar();
+			lexWorker->shiftLines(backgroundLexLineShift);
 		}
-	} break;
+
+		if (isStillValid && lexer.replaceLineStates(firstLine, lexWorker->takeLineStates(), lexWorker->getChunkFirstLines()))
+		{
+			printf("Info: Lexed %u lines of '%s' in the background in %zu chunks (%.2fms).\n", data.size() - lexWorker->getFirstLine(), name.c_str(), lexWorker->getChunkFirstLines().size(), lexWorker->getElapsedMs());
+			firstLineToLexInBackground = UINT_MAX;
+		}
+
+		lexWorker.reset();
 	}
-	
-	undoInformationPointer += 1;
-	numberOfActionsSinceSave += 1;
-	shouldAddToUndoInformation = true;
 
-	return true;
+	if (lexWorker || firstLineToLexInBackground == UINT_MAX || !isUsingSyntaxHighlighting || isLoading())
+	{
+		return;
+	}
+
+	if (firstLineToLexInBackground >= data.size())
+	{
+		firstLineToLexInBackground = UINT_MAX;
+		return;
+	}
+
+	// NOTE(fkp): Copying the text is the only part of this that isn't
+	// done on the worker thread, and it's a lot quicker than lexing it.
+	unsigned int firstLine = firstLineToLexInBackground;
+	unsigned int firstCopiedLine = firstLine > 0 ? firstLine - 1 : 0;
+	Point end { data.size() - 1, (unsigned int) data[data.size() - 1].size(), this };
+	std::string text = substrFromPoints(Point { firstCopiedLine, 0, this }, end);
+	LineLexState::FinishType finishTypeBefore = firstLine > 0 ? lexer.lineStates[firstLine - 1].finishType : LineLexState::FinishType::Finished;
+
+	lexWorker = std::make_unique<LexWorker>();
+	lexWorker->start(this, firstLine, std::move(text), finishTypeBefore);
+	backgroundLexLineShift = 0;
+	isBackgroundLexStale = false;
 }
 
-void Buffer::saveToFile()
+void Buffer::shiftLinesToLex(unsigned int line, int numberOfLines)
 {
-	// TODO(fkp): Check if changes need to be saved
-	if (path == "")
+	// NOTE(fkp): Removed lines are the ones after line, so the copy is
+	// only moved if all of them were before it.
+	if (lexWorker && !isBackgroundLexStale)
 	{
-		printf("Error: Cannot save non-file-visiting buffer.\n");
-		return;
+		unsigned int lastChangedLine = line + (numberOfLines < 0 ? (unsigned int) -numberOfLines : 0);
+
+		if (lastChangedLine < getBackgroundLexFirstLine())
+		{
+			backgroundLexLineShift += numberOfLines;
+		}
+		else
+		{
+			discardBackgroundLex();
+		}
 	}
 
-	std::ofstream file(path, std::ios::trunc);
+	if (firstLineToLexInBackground != UINT_MAX && firstLineToLexInBackground > line)
+	{
+		firstLineToLexInBackground = (unsigned int) std::max<long long>(line, (long long) firstLineToLexInBackground + numberOfLines);
+	}
 
-	if (!file)
+	if (firstLineToLex > lastLineToLex)
 	{
-		printf("Error: Failed to open file '%s' for saving to.\n", path.c_str());
 		return;
 	}
 
-	for (const std::string& line : data)
+	// NOTE(fkp): Lines that were removed are lexed as part of the line
+	// they were joined onto.
+	for (unsigned int* lineToLex : { &firstLineToLex, &lastLineToLex })
 	{
-		file << line << '\n';
+		if (*lineToLex > line)
+		{
+			*lineToLex = (unsigned int) std::max<long long>(line, (long long) *lineToLex + numberOfLines);
+		}
 	}
+}
 
-	numberOfActionsSinceSave = 0;
-	printf("Info: Saved buffer to file '%s'.\n", path.c_str());
+unsigned int Buffer::getBackgroundLexFirstLine() const
+{
+	return (unsigned int) ((long long) lexWorker->getFirstLine() + backgroundLexLineShift);
 }
 
-void Buffer::revertToFile()
+void Buffer::discardBackgroundLex()
 {
-	if (path == "")
-	{
-		writeToMinibuffer("Error: No file associated with this buffer.");
-		return;
-	}
-	else if (!doesFileExist(path.c_str()))
+	if (!lexWorker)
 	{
-		writeToMinibuffer("Error: File no longer exists on disk.");
 		return;
 	}
 
-	data.clear();
-	std::string fileContents = readFile(path.c_str());
+	// It's started again once it notices, from the first line still to lex
+	isBackgroundLexStale = true;
+	lexWorker->stop();
+}
 
-	std::string::size_type pos = 0;
-	std::string::size_type previous = 0;
+void Buffer::addActionToUndoBuffer(ActionType type, const Point& start, const Point& end, std::string_view text)
+{
+	if (numberOfTransactionsNotRecordingUndo > 0) return;
 
-	while ((pos = fileContents.find("\n", previous)) != std::string::npos)
-	{
-		data.emplace_back(fileContents.substr(previous, pos - previous));
-		previous = pos + 1;
-	}
+	journal.append(type, start, text);
 
-	// Last one
-	data.emplace_back(fileContents.substr(previous));
+	// The first edit in a transaction starts a new step in the history
+	bool continuesGroup = isInTransaction() && hasStartedUndoGroup;
+	hasStartedUndoGroup = true;
 
-	// Adjustment of the point and mark in relevant frames
-	for (Frame* frame : *Frame::allFrames)
+	// Appending to the last insertion
+	if (type == ActionType::Insertion && text.size() == 1 &&
+		undoTree.canAppendToCurrent(ActionType::Insertion))
 	{
-		if (frame->currentBuffer != this)
-		{
-			continue;
-		}
-		
-		if (frame->point.line >= data.size())
-		{
-			frame->point.line = data.size();
-		}
+		Point lastStart = undoTree.getCurrentStart();
+		Point lastEnd = undoTree.getCurrentEnd();
 
-		if (frame->point.col > data[frame->point.line].size())
+		// TODO(fkp): This is is a little unwieldy
+		if (start.line == lastEnd.line && start.col == lastEnd.col &&
+			lastEnd.line == lastStart.line &&
+			lastEnd.col - lastStart.col < 16 &&
+			lastEnd.col > 0 && lastEnd.col <= data[lastEnd.line].size() &&
+			data[lastEnd.line][lastEnd.col - 1] != ' ' &&
+			data[lastEnd.line][lastEnd.col - 1] != '\t' &&
+			lastEnd.col - 1 != data[lastEnd.line].size())
 		{
-			frame->point.col = data[frame->point.line].size();
+			if (text[0] == '\n')
+			{
+				lastEnd.line += 1;
+				lastEnd.col = 0;
+			}
+			else
+			{
+				lastEnd.col += 1;
+			}
+			
+			undoTree.appendToCurrent(text, lastEnd);
+			return;
 		}
-
-		frame->mark.line = frame->point.line;
-		frame->mark.col = frame->point.col;
 	}
 
-	// TODO(fkp): Maybe make it so undo history isn't cleared?
-	undoInformation.clear();
-	undoInformationPointer = 0;
-	numberOfActionsSinceSave = 0;
-	
-	// Lexing
-	// Automatic syntax highlighting based on file extension
-	// TODO(fkp): Different highlighting for C files
-	std::string extension = path.substr(path.find_last_of('.') + 1);
-	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
-		
-	static std::unordered_set<std::string> cppExtensions = {
-		"h", "hpp", "hxx",
-		"c", "cpp", "cxx", "cc",
-	};
+	undoTree.add(type, start, end, text, continuesGroup);
 
-	if (cppExtensions.find(extension) != cppExtensions.end())
+	if (!continuesGroup)
 	{
-		isUsingSyntaxHighlighting = true;
-		lexer.lex(0, true);
+		numberOfActionsSinceSave += 1;
 	}
 }
 
-std::string Buffer::substrFromPoints(const Point& start, const Point& end)
+bool Buffer::undo(Point& point)
 {
-	std::string substr = "";
+	std::vector<Action> actions;
 
-	for (int i = start.line; i <= end.line; i++)
+	if (!undoTree.undo(actions))
 	{
-		if (i < 0 || i >= data.size())
-		{
-			break;
-		}
-		
-		substr += data[i];
-		substr += std::string(1, '\n');
+		return false;
+	}
+
+	std::vector<Action> oppositeActions;
+	oppositeActions.reserve(actions.size());
+
+	for (const Action& action : actions)
+	{
+		Action opposite = action;
+		opposite.type = action.type == ActionType::Insertion ? ActionType::Deletion : ActionType::Insertion;
+
+		// The journal only has things going forwards, so this is the opposite
+		journal.append(opposite.type, opposite.start, opposite.data);
+		oppositeActions.push_back(std::move(opposite));
 	}
 
-	return ::substrFromPoints(substr, start, end, start.line);
+	beginTransaction(false);
+	doActions(oppositeActions, point);
+	commitTransaction();
+	numberOfActionsSinceSave -= 1;
+	hasStartedUndoGroup = false;
+
+	return true;
 }
 
-std::string substrFromPoints(const std::string& string, const Point& start, const Point& end, unsigned int lineOffset)
+// NOTE(fkp): This is basically the exact opposite to undo()
+bool Buffer::redo(Point& point)
 {
-	if (start > end)
+	std::vector<Action> actions;
+
+	if (!undoTree.redo(actions))
 	{
-		ERROR_ONCE("Error: Start cannot be after end in substr.\n");
-		return "";
+		return false;
 	}
 
-	if (lineOffset > start.line)
+	for (const Action& action : actions)
 	{
-		ERROR_ONCE("Error: String starts after the requested start point in substr.\n");
-		return "";
+		journal.append(action);
 	}
-	
-	unsigned int startIndex = 0;
-	unsigned int currentIndex = 0;
-	unsigned int linesPassed = lineOffset;
-	
-	while (currentIndex < string.size() && linesPassed < start.line)
+
+	beginTransaction(false);
+	doActions(actions, point);
+	commitTransaction();
+	numberOfActionsSinceSave += 1;
+	hasStartedUndoGroup = false;
+
+	return true;
+}
+
+void Buffer::doActions(const std::vector<Action>& actions, Point& point)
+{
+	std::vector<Action> edits;
+
+	if (actions.size() < 2 || !getActionsAsEdits(actions, edits))
 	{
-		if (string[currentIndex] == '\n')
+		for (const Action& action : actions)
 		{
-			linesPassed += 1;
+			switch (action.type)
+			{
+			case ActionType::Insertion:
+			{
+				point = insertText(action.start, action.data);
+			} break;
+
+			case ActionType::Deletion:
+			{
+				eraseRange(action.start, action.end);
+				point = action.start;
+			} break;
+			}
 		}
 
-		currentIndex += 1;
+		return;
 	}
 
-	currentIndex += start.col;
-	startIndex = currentIndex;
-	linesPassed = 0;
-	unsigned int length = 0;
+	// NOTE(fkp): This is the same as insertTextAtPoints() and
+	// eraseRanges(), with both kinds of edit.
+	std::vector<AnchorSet::Edit> anchorEdits(edits.size());
+	std::vector<LineChange> lineChanges(edits.size());
 
-	while (currentIndex < string.size() && linesPassed < end.line - start.line)
+	for (std::size_t i = edits.size(); i-- > 0;)
 	{
-		if (string[currentIndex] == '\n')
+		const Action& edit = edits[i];
+		Point start { edit.start.line, std::min<unsigned int>(edit.start.col, data[edit.start.line].size()), this };
+		Point end = edit.end;
+
+		if (edit.type == ActionType::Insertion)
 		{
-			linesPassed += 1;
+			end = insertIntoData(start, edit.data);
+			anchorEdits[i].end = start;
+			anchorEdits[i].numberOfNewlines = end.line - start.line;
+			anchorEdits[i].lastLineSize = end.line == start.line ? end.col - start.col : end.col;
+			lineChanges[i] = LineChange { start.line, 0, end.line - start.line };
+
+			if (isUsingSyntaxHighlighting)
+			{
+				shiftLinesToLex(start.line, (int) (end.line - start.line));
+				lexLines(start.line, end.line);
+			}
 		}
+		else
+		{
+			eraseFromData(start, end);
+			anchorEdits[i].end = end;
+			lineChanges[i] = LineChange { start.line, end.line - start.line, 0 };
 
-		length += 1;
-		currentIndex += 1;
+			if (isUsingSyntaxHighlighting)
+			{
+				shiftLinesToLex(start.line, -(int) (end.line - start.line));
+				lexLines(start.line, start.line);
+			}
+		}
+
+		anchorEdits[i].start = start;
 	}
 
-	// The final line
-	if (start.line == end.line)
+	if (isUsingSyntaxHighlighting)
 	{
-		length += end.col - start.col;
+		lexer.adjustLines(lineChanges);
 	}
-	else
+
+	anchors.moveForEdits(anchorEdits);
+
+	// Nothing after the last action moves it
+	const Action& lastAction = actions.back();
+	point = lastAction.type == ActionType::Insertion ? getPointAfterText(lastAction.start, lastAction.data) : lastAction.start;
+}
+
+bool Buffer::getActionsAsEdits(const std::vector<Action>& actions, std::vector<Action>& edits)
+{
+	bool isEachBeforeTheLast = true;
+	bool isEachAfterTheLast = true;
+
+	for (std::size_t i = 0; i < actions.size(); i++)
 	{
-		length += end.col;
-	}
+		const Action& action = actions[i];
+		Point end = action.type == ActionType::Insertion ? action.start : action.end;
 
-	return string.substr(startIndex, length);
+		// Empty deletions are left to eraseRange()
+		if (action.type == ActionType::Deletion && !(action.start < action.end))
+		{
+			return false;
+		}
+
+		if (i == 0) continue;
+
+		const Action& last = actions[i - 1];
+		Point lastEnd = last.type == ActionType::Insertion ? getPointAfterText(last.start, last.data) : last.start;
+		isEachBeforeTheLast = isEachBeforeTheLast && end < last.start;
+		isEachAfterTheLast = isEachAfterTheLast && lastEnd < action.start;
+	}
+
+	// NOTE(fkp): Going backwards, each action is already in positions
+	// from before all of them.
+	if (isEachBeforeTheLast)
+	{
+		edits.assign(actions.rbegin(), actions.rend());
+		return true;
+	}
+
+	if (!isEachAfterTheLast)
+	{
+		return false;
+	}
+
+	// Going forwards, each action is moved back past the ones before it
+	// (the opposite of what AnchorSet::moveForEdits() does).
+	long long lineOffset = 0;
+	unsigned int lastEditEndLine = UINT_MAX;
+	long long colOffset = 0;
+
+	auto movePointBack = [&](Point point)
+	{
+		if (point.line == lastEditEndLine)
+		{
+			point.col = (unsigned int) (point.col - colOffset);
+		}
+
+		point.line = (unsigned int) (point.line - lineOffset);
+		return point;
+	};
+
+	edits.reserve(actions.size());
+
+	for (const Action& action : actions)
+	{
+		Action edit = action;
+		edit.start = movePointBack(action.start);
+		edit.end = action.type == ActionType::Insertion ? edit.start : movePointBack(action.end);
+
+		Point endAfter = action.type == ActionType::Insertion ? getPointAfterText(action.start, action.data) : action.start;
+		lineOffset = (long long) endAfter.line - (long long) edit.end.line;
+		lastEditEndLine = endAfter.line;
+		colOffset = (long long) endAfter.col - (long long) edit.end.col;
+
+		edits.push_back(std::move(edit));
+	}
+
+	return true;
+}
+
+void Buffer::saveToFile()
+{
+	// TODO(fkp): Check if changes need to be saved
+	if (path == "")
+	{
+		printf("Error: Cannot save non-file-visiting buffer.\n");
+		return;
+	}
+	else if (isPaged())
+	{
+		// Only part of the file is loaded, it would be lost
+		printf("Error: Cannot save a paged buffer.\n");
+		return;
+	}
+
+	// Saving a partly loaded buffer would cut the file short
+	finishLoading();
+	finishSaving();
+
+	// NOTE(fkp): The file can't be replaced while it is mapped, so the
+	// mapped text has to be copied out first. It is mapped again once
+	// it has been written.
+	data.detachFromMapping();
+
+	// NOTE(fkp): This is a snapshot, so the buffer can still be edited
+	// while it is written. Lines end in "\r\n" like the old text mode
+	// stream wrote them.
+	std::string contents;
+	contents.reserve(data.getNumberOfChars() + data.size() * 2);
+
+	for (unsigned int i = 0; i < data.size(); i++)
+	{
+		LineView line = data[i];
+		contents.append(line.data(), line.size());
+		contents += "\r\n";
+	}
+
+	if (numberOfSavesInProgress == 0)
+	{
+		numberOfSavesInBatch = 0;
+		numberOfBytesSavedInBatch = 0;
+		saveBatchTimer.reset();
+	}
+
+	numberOfSavesInProgress += 1;
+	numberOfActionsBeingSaved = numberOfActionsSinceSave;
+	numberOfActionsSinceSave = 0;
+	numberOfEditsBeingSaved = data.getNumberOfEdits();
+	journal.flush();
+	journal.startSave();
+
+	saver = std::make_unique<FileSaver>();
+	saver->start(path, std::move(contents));
+}
+
+void Buffer::updateSaving()
+{
+	if (saver && saver->isFinished())
+	{
+		onSaveFinished();
+	}
+}
+
+void Buffer::finishSaving()
+{
+	if (saver)
+	{
+		saver->waitUntilFinished();
+		onSaveFinished();
+	}
+}
+
+void Buffer::finishAllSaves()
+{
+	for (std::pair<const std::string, Buffer*>& pair : buffersMap)
+	{
+		pair.second->finishSaving();
+	}
+}
+
+void Buffer::discardAllJournals()
+{
+	for (std::pair<const std::string, Buffer*>& pair : buffersMap)
+	{
+		pair.second->journal.discard();
+	}
+}
+
+void Buffer::onSaveFinished()
+{
+	numberOfSavesInProgress -= 1;
+	journal.finishSave(path, saver->didSucceed());
+
+	if (saver->didSucceed())
+	{
+		numberOfSavesInBatch += 1;
+		numberOfBytesSavedInBatch += saver->getSize();
+		printf("Info: Saved buffer to file '%s' (%.2fms).\n", path.c_str(), saver->getElapsedMs());
+
+		// NOTE(fkp): Anything edited since the snapshot would be lost by
+		// mapping it. The number of actions can't tell, an undo and then
+		// a new edit adds up to none.
+		if (openMode == FileOpenMode::Mapped && data.getNumberOfEdits() == numberOfEditsBeingSaved)
+		{
+			FileMapping mapping;
+
+			if (mapping.open(path))
+			{
+				data.loadFromMapping(std::move(mapping));
+				if (isInterningLines) internLines();
+			}
+		}
+	}
+	else
+	{
+		numberOfActionsSinceSave += numberOfActionsBeingSaved;
+		writeToMinibuffer("Error: Failed to save \"" + path + "\".");
+	}
+
+	saver.reset();
+	numberOfActionsBeingSaved = 0;
+
+	// NOTE(fkp): Don't overwrite anything the user is typing
+	if (numberOfSavesInProgress == 0 && numberOfSavesInBatch > 0 &&
+		Commands::currentlyReading == MinibufferReading::None)
+	{
+		double elapsedMs = saveBatchTimer.getElapsedMs();
+		double megabytes = (double) numberOfBytesSavedInBatch / (1024.0 * 1024.0);
+		char message[128];
+
+		if (numberOfSavesInBatch == 1)
+		{
+			snprintf(message, sizeof(message), "%.1fMB in %.0fms, %.1fMB/s", megabytes, elapsedMs, megabytes / (elapsedMs / 1000.0));
+			writeToMinibuffer("Saved \"" + path + "\" (" + message + ")");
+		}
+		else
+		{
+			snprintf(message, sizeof(message), "Saved %u buffers (%.1fMB in %.0fms, %.1fMB/s)", numberOfSavesInBatch, megabytes, elapsedMs, megabytes / (elapsedMs / 1000.0));
+			writeToMinibuffer(message);
+		}
+	}
+}
+
+void Buffer::revertToFile(bool shouldKeepJournal)
+{
+	if (path == "")
+	{
+		writeToMinibuffer("Error: No file associated with this buffer.");
+		return;
+	}
+	else if (!doesFileExist(path.c_str()))
+	{
+		writeToMinibuffer("Error: File no longer exists on disk.");
+		return;
+	}
+
+	// The file on disk might be about to change
+	finishSaving();
+
+	// The piece table keeps the file contents as they are and splits
+	// them into lines itself
+	FileMapping mapping;
+	pagedFile.reset();
+	loader.reset();
+	numberOfLoadedLines = 0;
+	discardBackgroundLex();
+
+	if (openMode != FileOpenMode::Paged)
+	{
+		journal.reset(path, shouldKeepJournal);
+	}
+
+	if (openMode == FileOpenMode::Paged)
+	{
+		pagedFile = std::make_unique<PagedFile>();
+
+		if (!pagedFile->open(path))
+		{
+			pagedFile.reset();
+		}
+	}
+	
+	if (isPaged())
+	{
+		isReadOnly = true;
+		loadPage(0, 0, true);
+	}
+	else if (openMode == FileOpenMode::Mapped && mapping.open(path))
+	{
+		data.loadFromMapping(std::move(mapping));
+	}
+	else
+	{
+		// NOTE(fkp): Only the start of the file is read here so the
+		// first screen can be drawn straight away. updateLoading() adds
+		// the rest as it is read.
+		std::string firstPart;
+		loader = std::make_unique<FileLoader>();
+
+		if (!loader->start(path, firstPart))
+		{
+			loader.reset();
+		}
+		
+		data.loadFromString(std::move(firstPart));
+	}
+
+	// Adjustment of the point and mark in relevant frames
+	for (Frame* frame : *Frame::allFrames)
+	{
+		if (frame->currentBuffer != this)
+		{
+			continue;
+		}
+		
+		if (frame->point.line >= data.size())
+		{
+			frame->point.line = data.size();
+		}
+
+		if (frame->point.col > data[frame->point.line].size())
+		{
+			frame->point.col = data[frame->point.line].size();
+		}
+
+		frame->mark.line = frame->point.line;
+		frame->mark.col = frame->point.col;
+	}
+
+	// A file that is still loading is interned once it's done
+	if (isInterningLines && !isPaged() && !isLoading())
+	{
+		internLines();
+	}
+
+	// TODO(fkp): Maybe make it so undo history isn't cleared?
+	undoTree.clear();
+	numberOfActionsSinceSave = 0;
+
+	// NOTE(fkp): The lexer needs the whole file, so paged buffers are
+	// never highlighted.
+	if (isPaged())
+	{
+		return;
+	}
+	
+	// Lexing
+	// Automatic syntax highlighting based on file extension
+	// TODO(fkp): Different highlighting for C files
+	std::string extension = path.substr(path.find_last_of('.') + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+		
+	static std::unordered_set<std::string> cppExtensions = {
+		"h", "hpp", "hxx",
+		"c", "cpp", "cxx", "cc",
+	};
+
+	if (cppExtensions.find(extension) != cppExtensions.end())
+	{
+		isUsingSyntaxHighlighting = true;
+		lexWholeBuffer();
+	}
+}
+
+bool Buffer::startShellFilter(const std::string& command, const Point& start, const Point& end)
+{
+	if (shellFilter)
+	{
+		writeToMinibuffer("Error: \"" + shellFilter->getCommand() + "\" is still running.");
+		return false;
+	}
+
+	shellFilter = std::make_unique<ShellFilter>();
+	shellFilter->regionStart = start;
+	shellFilter->regionEnd = end;
+
+	if (!shellFilter->start(command, substrFromPoints(start, end)))
+	{
+		shellFilter.reset();
+		writeToMinibuffer("Error: Failed to run \"" + command + "\".");
+		return false;
+	}
+
+	// NOTE(fkp): Text typed at either edge of the region ends up outside
+	// it, so only what was there to begin with gets replaced.
+	anchors.add(&shellFilter->regionStart, AnchorGravity::Right);
+	anchors.add(&shellFilter->regionEnd, AnchorGravity::Left);
+
+	return true;
+}
+
+void Buffer::cancelShellFilter()
+{
+	if (shellFilter)
+	{
+		shellFilter->cancel();
+	}
+}
+
+bool Buffer::isRunningShellFilter() const
+{
+	return shellFilter != nullptr;
+}
+
+void Buffer::updateShellFilter()
+{
+	if (!shellFilter || !shellFilter->isFinished())
+	{
+		return;
+	}
+
+	std::unique_ptr<ShellFilter> filter = std::move(shellFilter);
+	anchors.remove({ &filter->regionStart, &filter->regionEnd });
+
+	if (filter->isCancelled())
+	{
+		writeToMinibuffer("Cancelled \"" + filter->getCommand() + "\".");
+		return;
+	}
+	else if (!filter->didSucceed())
+	{
+		writeToMinibuffer("Error: \"" + filter->getCommand() + "\" exited with code " + std::to_string(filter->getExitCode()) + ", the region is unchanged.");
+		return;
+	}
+
+	std::string output = filter->takeOutput();
+	Point start = filter->regionStart;
+	Point end = filter->regionEnd;
+
+	// Most commands end their output with a newline, which the region
+	// didn't have if it ended part way through a line.
+	if (end.col != 0 && output.size() > 0 && output.back() == '\n')
+	{
+		output.pop_back();
+		if (output.size() > 0 && output.back() == '\r') output.pop_back();
+	}
+
+	// The whole region is replaced as one step in the undo history
+	beginTransaction();
+	eraseRange(start, end);
+	insertText(start, output);
+	commitTransaction();
+
+	char message[128];
+	snprintf(message, sizeof(message), " (%zu bytes in, %zu bytes out, %.0fms)", filter->getInputSize(), filter->getNumberOfBytesRead(), filter->getElapsedMs());
+	writeToMinibuffer("Filtered the region through \"" + filter->getCommand() + "\"" + message);
+}
+
+void Buffer::recoverFromJournal(std::vector<Action>& actions)
+{
+	if (actions.size() == 0)
+	{
+		return;
+	}
+
+	// The edits could be anywhere in the file
+	finishLoading();
+	Timer timer;
+
+	for (Action& action : actions)
+	{
+		applyAction(action);
+		journal.append(action);
+	}
+
+	// NOTE(fkp): The old journal file was kept until now, this replaces
+	// it with the same records.
+	journal.flush();
+
+	// NOTE(fkp): The end points aren't in the journal, they are worked
+	// out here so the recovered actions can be undone.
+	for (const Action& action : actions)
+	{
+		undoTree.add(action.type, action.start, getPointAfterText(action.start, action.data), action.data);
+	}
+
+	numberOfActionsSinceSave = (unsigned int) actions.size();
+
+	if (isUsingSyntaxHighlighting)
+	{
+		lexWholeBuffer();
+	}
+
+	printf("Info: Recovered %zu unsaved edits to '%s' in %.2fms.\n", actions.size(), path.c_str(), timer.getElapsedMs());
+}
+
+void Buffer::applyAction(const Action& action)
+{
+	unsigned int line = action.start.line;
+
+	if (line >= data.size())
+	{
+		ERROR_ONCE("Error: Action is outside of the buffer.\n");
+		return;
+	}
+
+	Point start { line, std::min<unsigned int>(action.start.col, data[line].size()), this };
+
+	switch (action.type)
+	{
+	case ActionType::Insertion:
+	{
+		insertIntoData(start, action.data);
+	} break;
+
+	case ActionType::Deletion:
+	{
+		Point end = getPointAfterText(start, action.data);
+
+		if (end.line >= data.size())
+		{
+			ERROR_ONCE("Error: Action is outside of the buffer.\n");
+			break;
+		}
+
+		eraseFromData(start, end);
+	} break;
+	}
+}
+
+Point Buffer::insertText(const Point& start, std::string_view text)
+{
+	// Windows has CRLF endings
+	std::string textWithoutCarriageReturns;
+
+	if (text.find('\r') != std::string_view::npos)
+	{
+		textWithoutCarriageReturns.reserve(text.size());
+		std::copy_if(text.begin(), text.end(), std::back_inserter(textWithoutCarriageReturns), [](char character) { return character != '\r'; });
+		text = textWithoutCarriageReturns;
+	}
+
+	Point clampedStart { start.line, std::min<unsigned int>(start.col, data[start.line].size()), this };
+	Point end = insertIntoData(clampedStart, text);
+
+	if (isUsingSyntaxHighlighting)
+	{
+		lexer.addLines(clampedStart.line, end.line - clampedStart.line);
+		shiftLinesToLex(clampedStart.line, (int) (end.line - clampedStart.line));
+		lexLines(clampedStart.line, end.line);
+	}
+
+	anchors.moveForInsertion(clampedStart, end);
+	addActionToUndoBuffer(ActionType::Insertion, clampedStart, end, text);
+
+	return end;
+}
+
+std::string Buffer::eraseRange(const Point& start, const Point& end)
+{
+	if (start >= end)
+	{
+		return "";
+	}
+
+	std::string text = substrFromPoints(start, end);
+	eraseFromData(start, end);
+
+	if (isUsingSyntaxHighlighting)
+	{
+		lexer.removeLines(start.line, end.line - start.line);
+		shiftLinesToLex(start.line, -(int) (end.line - start.line));
+		lexLines(start.line, start.line);
+	}
+
+	anchors.moveForDeletion(start, end);
+	addActionToUndoBuffer(ActionType::Deletion, start, end, text);
+
+	return text;
+}
+
+void Buffer::insertTextAtPoints(const std::vector<Point>& points, std::string_view text)
+{
+	std::string textWithoutCarriageReturns;
+
+	if (text.find('\r') != std::string_view::npos)
+	{
+		textWithoutCarriageReturns.reserve(text.size());
+		std::copy_if(text.begin(), text.end(), std::back_inserter(textWithoutCarriageReturns), [](char character) { return character != '\r'; });
+		text = textWithoutCarriageReturns;
+	}
+
+	std::size_t lastNewline = text.rfind('\n');
+	AnchorSet::Edit edit;
+	edit.numberOfNewlines = (unsigned int) countNewlines(text.data(), text.data() + text.size());
+	edit.lastLineSize = (unsigned int) (lastNewline == std::string_view::npos ? text.size() : text.size() - lastNewline - 1);
+
+	std::vector<AnchorSet::Edit> edits(points.size(), edit);
+	std::vector<LineChange> lineChanges(points.size());
+	beginTransaction();
+
+	// NOTE(fkp): Going backwards leaves the points before each edit
+	// where they were, so nothing has to be adjusted along the way.
+	for (std::size_t i = points.size(); i-- > 0;)
+	{
+		const Point& point = points[i];
+		Point start { point.line, std::min<unsigned int>(point.col, data[point.line].size()), this };
+		Point end = insertIntoData(start, text);
+
+		if (isUsingSyntaxHighlighting)
+		{
+			shiftLinesToLex(start.line, (int) (end.line - start.line));
+			lexLines(start.line, end.line);
+		}
+
+		addActionToUndoBuffer(ActionType::Insertion, start, end, text);
+		edits[i].start = start;
+		edits[i].end = start;
+		lineChanges[i] = LineChange { start.line, 0, end.line - start.line };
+	}
+
+	if (isUsingSyntaxHighlighting)
+	{
+		lexer.adjustLines(lineChanges);
+	}
+
+	anchors.moveForEdits(edits);
+	commitTransaction();
+}
+
+void Buffer::eraseRanges(const std::vector<std::pair<Point, Point>>& ranges)
+{
+	std::vector<AnchorSet::Edit> edits;
+	std::vector<LineChange> lineChanges;
+	edits.reserve(ranges.size());
+	lineChanges.reserve(ranges.size());
+	beginTransaction();
+
+	for (std::size_t i = ranges.size(); i-- > 0;)
+	{
+		const Point& start = ranges[i].first;
+		const Point& end = ranges[i].second;
+
+		if (start >= end)
+		{
+			continue;
+		}
+
+		std::string text = substrFromPoints(start, end);
+		eraseFromData(start, end);
+
+		if (isUsingSyntaxHighlighting)
+		{
+			shiftLinesToLex(start.line, -(int) (end.line - start.line));
+			lexLines(start.line, start.line);
+		}
+
+		addActionToUndoBuffer(ActionType::Deletion, start, end, text);
+
+		AnchorSet::Edit edit;
+		edit.start = start;
+		edit.end = end;
+		edits.push_back(edit);
+		lineChanges.push_back(LineChange { start.line, end.line - start.line, 0 });
+	}
+
+	std::reverse(edits.begin(), edits.end());
+	std::reverse(lineChanges.begin(), lineChanges.end());
+
+	if (isUsingSyntaxHighlighting)
+	{
+		lexer.adjustLines(lineChanges);
+	}
+
+	anchors.moveForEdits(edits);
+	commitTransaction();
+}
+
+Point Buffer::replaceLines(unsigned int firstLine, unsigned int lastLine, std::string_view text)
+{
+	beginTransaction();
+
+	Point start { firstLine, 0, this };
+	eraseRange(start, Point { lastLine, (unsigned int) data[lastLine].size(), this });
+	Point end = insertText(start, text);
+
+	commitTransaction();
+
+	return end;
+}
+
+void Buffer::editLines(unsigned int firstLine, const std::vector<LineEdit>& edits)
+{
+	if (edits.size() == 0)
+	{
+		return;
+	}
+
+	unsigned int lastLine = firstLine + (unsigned int) edits.size() - 1;
+	Point start { firstLine, 0, this };
+	Point end { lastLine, (unsigned int) data[lastLine].size(), this };
+	std::string oldText = substrFromPoints(start, end);
+	std::string newText;
+	std::vector<AnchorSet::Edit> anchorEdits;
+	std::size_t lineStart = 0;
+
+	newText.reserve(oldText.size() + edits.size() * edits[0].text.size());
+
+	for (unsigned int i = 0; i < edits.size(); i++)
+	{
+		std::size_t lineEnd = std::min(oldText.find('\n', lineStart), oldText.size());
+		std::string_view line { oldText.data() + lineStart, lineEnd - lineStart };
+		unsigned int startCol = std::min<unsigned int>(edits[i].startCol, (unsigned int) line.size());
+		unsigned int endCol = std::clamp<unsigned int>(edits[i].endCol, startCol, (unsigned int) line.size());
+
+		newText.append(line.substr(0, startCol));
+		newText.append(edits[i].text);
+		newText.append(line.substr(endCol));
+		if (i != edits.size() - 1) newText += '\n';
+
+		if (startCol != endCol || edits[i].text.size() > 0)
+		{
+			AnchorSet::Edit edit;
+			edit.start = Point { firstLine + i, startCol, this };
+			edit.end = Point { firstLine + i, endCol, this };
+			edit.lastLineSize = (unsigned int) edits[i].text.size();
+			anchorEdits.push_back(edit);
+		}
+
+		lineStart = lineEnd + 1;
+	}
+
+	if (anchorEdits.size() == 0)
+	{
+		return;
+	}
+
+	// NOTE(fkp): The number of lines is the same, so the lexer only has
+	// to go over them again.
+	beginTransaction();
+	eraseFromData(start, end);
+	Point newEnd = insertIntoData(start, newText);
+
+	if (isUsingSyntaxHighlighting)
+	{
+		lexLines(firstLine, lastLine);
+	}
+
+	addActionToUndoBuffer(ActionType::Deletion, start, end, oldText);
+	addActionToUndoBuffer(ActionType::Insertion, start, newEnd, newText);
+	anchors.moveForEdits(anchorEdits);
+	commitTransaction();
+}
+
+Point Buffer::insertIntoData(const Point& start, std::string_view text)
+{
+	unsigned int line = start.line;
+	unsigned int col = start.col;
+	std::size_t firstNewline = text.find('\n');
+
+	if (firstNewline == std::string_view::npos)
+	{
+		data.insertText(line, col, text);
+		return Point { line, col + (unsigned int) text.size(), this };
+	}
+
+	// The first and last parts go onto the split line, everything in
+	// between is whole lines.
+	std::size_t lastNewline = text.rfind('\n');
+	unsigned int numberOfNewlines = (unsigned int) countNewlines(text.data(), text.data() + text.size());
+
+	data.splitLine(line, col);
+	data.insertText(line, col, text.substr(0, firstNewline));
+
+	if (lastNewline != firstNewline)
+	{
+		data.spliceLines(line + 1, text.substr(firstNewline + 1, lastNewline - firstNewline - 1));
+	}
+
+	std::string_view lastPart = text.substr(lastNewline + 1);
+	data.insertText(line + numberOfNewlines, 0, lastPart);
+
+	return Point { line + numberOfNewlines, (unsigned int) lastPart.size(), this };
+}
+
+void Buffer::eraseFromData(const Point& start, const Point& end)
+{
+	unsigned int line = start.line;
+	unsigned int col = start.col;
+
+	if (end.line == line)
+	{
+		data.eraseText(line, col, std::min<unsigned int>(end.col, data[line].size()) - col);
+		return;
+	}
+
+	data.eraseText(line, col, data[line].size() - col);
+	data.eraseLines(line + 1, end.line - line - 1);
+	data.eraseText(line + 1, 0, std::min<unsigned int>(end.col, data[line + 1].size()));
+	data.joinLines(line);
+}
+
+unsigned int Buffer::internLines()
+{
+	Timer timer;
+	unsigned int numberOfDistinctLines = data.internLines();
+
+	printf("Info: Interned %u distinct lines of %u in '%s' (%.2fms).\n", numberOfDistinctLines, data.size(), name.c_str(), timer.getElapsedMs());
+	return numberOfDistinctLines;
+}
+
+bool Buffer::isLoading() const
+{
+	return loader != nullptr;
+}
+
+void Buffer::updateLoading()
+{
+	if (!loader)
+	{
+		return;
+	}
+
+	std::string text;
+
+	if (loader->takeLoadedText(text))
+	{
+		unsigned int oldNumberOfLines = data.size();
+		data.insertLines(data.size() - 1, text);
+
+		unsigned int numberOfNewLines = data.size() - oldNumberOfLines;
+		numberOfLoadedLines += numberOfNewLines;
+		discardBackgroundLex();
+
+		// Keeps the lexer in line with the buffer until they are lexed
+		if (isUsingSyntaxHighlighting && lexer.lineStates.size() == oldNumberOfLines)
+		{
+			lexer.lineStates.insert(lexer.lineStates.end() - 1, numberOfNewLines, LineLexState {});
+		}
+	}
+
+	if (loader->isFinished())
+	{
+		loader.reset();
+
+		if (isInterningLines)
+		{
+			internLines();
+		}
+
+		// NOTE(fkp): Edits aren't allowed at the end while loading, so
+		// the loaded lines are all just before the last line.
+		if (isUsingSyntaxHighlighting)
+		{
+			lexInBackground(data.size() - 1 - numberOfLoadedLines);
+		}
+
+		numberOfLoadedLines = 0;
+	}
+}
+
+void Buffer::finishLoading()
+{
+	if (!loader)
+	{
+		return;
+	}
+
+	loader->waitUntilFinished();
+	updateLoading();
+}
+
+std::string Buffer::substrFromPoints(const Point& start, const Point& end)
+{
+	if (start > end)
+	{
+		ERROR_ONCE("Error: Start cannot be after end in substr.\n");
+		return "";
+	}
+
+	std::string substr;
+	substr.reserve(distance(start, end));
+
+	for (unsigned int i = start.line; i <= end.line && i < data.size(); i++)
+	{
+		LineView line = data[i];
+		std::size_t startCol = i == start.line ? std::min<std::size_t>(start.col, line.size()) : 0;
+		std::size_t endCol = i == end.line ? std::min<std::size_t>(end.col, line.size()) : line.size();
+
+		if (endCol > startCol)
+		{
+			substr.append(line.data() + startCol, endCol - startCol);
+		}
+
+		if (i != end.line)
+		{
+			substr += '\n';
+		}
+	}
+
+	return substr;
+}
+
+std::size_t Buffer::offsetOf(const Point& point) const
+{
+	if (point.line >= data.size())
+	{
+		return data.getNumberOfChars();
+	}
+
+	return data.getOffsetOfLine(point.line) + std::min<std::size_t>(point.col, data[point.line].size());
+}
+
+Point Buffer::pointAt(std::size_t offset) const
+{
+	if (offset > data.getNumberOfChars())
+	{
+		offset = data.getNumberOfChars();
+	}
+
+	std::size_t lineStartOffset;
+	unsigned int line = data.getLineAtOffset(offset, lineStartOffset);
+
+	return Point { line, (unsigned int) (offset - lineStartOffset), this };
+}
+
+std::size_t Buffer::distance(const Point& a, const Point& b) const
+{
+	std::size_t aOffset = offsetOf(a);
+	std::size_t bOffset = offsetOf(b);
+
+	return aOffset > bOffset ? aOffset - bOffset : bOffset - aOffset;
+}
+
+bool Buffer::findText(const Point& start, const std::string& text, Point& result)
+{
+	if (text == "" || start.line >= data.size())
+	{
+		return false;
+	}
+
+	if (isPaged())
+	{
+		// The file is searched directly, the match might not be loaded
+		std::uint64_t lineStartOffset = pagedLineOffsets[start.line];
+		std::uint64_t startOffset = lineStartOffset + std::min<std::size_t>(start.col, data[start.line].size()) + 1;
+		std::uint64_t foundOffset;
+		std::uint64_t numberOfNewlinesPassed;
+
+		if (!pagedFile->find(startOffset, text, foundOffset, lineStartOffset, numberOfNewlinesPassed))
+		{
+			return false;
+		}
+
+		std::uint64_t foundLine = start.line + numberOfNewlinesPassed;
+		unsigned int foundCol = (unsigned int) (foundOffset - lineStartOffset);
+
+		if (foundLine >= data.size())
+		{
+			std::uint64_t newStartOffset;
+			unsigned int numberOfLinesBefore = pagedFile->findStartOfPreviousLines(lineStartOffset, PAGED_WINDOW_MARGIN * 2, newStartOffset);
+
+			loadPage(newStartOffset, firstPagedLine + foundLine - numberOfLinesBefore, isFirstPagedLineKnown);
+			clampFramePoints();
+			foundLine = numberOfLinesBefore;
+		}
+
+		result = Point { (unsigned int) foundLine, foundCol, this };
+		return true;
+	}
+
+	std::size_t col = start.col + 1;
+
+	for (unsigned int line = start.line; line < data.size(); line++)
+	{
+		LineView lineText = data[line];
+		std::size_t index = col <= lineText.size() ? lineText.find(text, col) : std::string_view::npos;
+
+		if (index != std::string_view::npos)
+		{
+			result = Point { line, (unsigned int) index, this };
+			return true;
+		}
+
+		col = 0;
+	}
+
+	return false;
+}
+
+bool Buffer::isPaged() const
+{
+	return pagedFile != nullptr;
+}
+
+void Buffer::loadPage(std::uint64_t startOffset, std::uint64_t startLine, bool isStartLineKnown)
+{
+	std::string text = pagedFile->readLines(startOffset, PAGED_WINDOW_NUMBER_OF_LINES, pagedLineOffsets, pagedEndOffset);
+	bool isAtFileEnd = pagedEndOffset == pagedFile->getSize();
+
+	if (isAtFileEnd && text.size() > 0 && text.back() != '\n')
+	{
+		// Matches what readFile() does
+		text += '\n';
+	}
+
+	data.loadFromString(std::move(text));
+	discardBackgroundLex();
+
+	if (isAtFileEnd)
+	{
+		// The empty line at the end
+		pagedLineOffsets.push_back(pagedEndOffset);
+	}
+	else
+	{
+		// The last line's newline doesn't start another line yet
+		data.eraseLine(data.size() - 1);
+	}
+
+	firstPagedLine = startLine;
+	isFirstPagedLineKnown = isStartLineKnown;
+}
+
+// Moves the window if the lines are near either end of it
+void Buffer::ensurePagedLinesLoaded(int firstLine, unsigned int numberOfLines)
+{
+	if (!isPaged())
+	{
+		return;
+	}
+
+	int lastLine = firstLine + (int) numberOfLines;
+	bool isAtFileStart = pagedLineOffsets[0] == 0;
+	bool isAtFileEnd = pagedEndOffset == pagedFile->getSize();
+
+	if ((firstLine < (int) PAGED_WINDOW_MARGIN && !isAtFileStart) ||
+		(lastLine + (int) PAGED_WINDOW_MARGIN > (int) data.size() && !isAtFileEnd))
+	{
+		// Puts the lines in the middle of the new window
+		shiftPage(firstLine + (int) (numberOfLines / 2) - (int) (PAGED_WINDOW_NUMBER_OF_LINES / 2));
+	}
+}
+
+static void shiftLine(unsigned int& line, int numberOfLines, unsigned int maxLine)
+{
+	int newLine = (int) line - numberOfLines;
+	line = (unsigned int) std::clamp(newLine, 0, (int) maxLine);
+}
+
+static void shiftLine(int& line, int numberOfLines, unsigned int maxLine)
+{
+	line = std::clamp(line - numberOfLines, 0, (int) maxLine);
+}
+
+// Moves the window forward (or back) by a number of lines. Frames
+// showing the buffer stay on the same text.
+void Buffer::shiftPage(int numberOfLines)
+{
+	if (!isPaged() || numberOfLines == 0)
+	{
+		return;
+	}
+
+	int numberOfLinesMoved;
+
+	if (numberOfLines > 0)
+	{
+		if (pagedEndOffset == pagedFile->getSize())
+		{
+			return;
+		}
+
+		numberOfLinesMoved = std::min(numberOfLines, (int) data.size() - 1);
+		loadPage(pagedLineOffsets[numberOfLinesMoved], firstPagedLine + numberOfLinesMoved, isFirstPagedLineKnown);
+	}
+	else
+	{
+		std::uint64_t newStartOffset;
+		unsigned int numberOfLinesBefore = pagedFile->findStartOfPreviousLines(pagedLineOffsets[0], -numberOfLines, newStartOffset);
+
+		if (numberOfLinesBefore == 0)
+		{
+			return;
+		}
+
+		numberOfLinesMoved = -(int) numberOfLinesBefore;
+		loadPage(newStartOffset, firstPagedLine - numberOfLinesBefore, isFirstPagedLineKnown);
+	}
+
+	unsigned int lastLine = data.size() - 1;
+
+	for (Frame* frame : *Frame::allFrames)
+	{
+		if (frame->currentBuffer != this)
+		{
+			continue;
+		}
+
+		shiftLine(frame->currentTopLine, numberOfLinesMoved, lastLine);
+		shiftLine(frame->targetTopLine, numberOfLinesMoved, lastLine);
+	}
+
+	anchors.forEach([&](Point& point)
+					{
+						shiftLine(point.line, numberOfLinesMoved, lastLine);
+					});
+	shiftLine(lastTopLine, numberOfLinesMoved, lastLine);
+	clampFramePoints();
+}
+
+void Buffer::pageToStart()
+{
+	if (isPaged() && pagedLineOffsets[0] != 0)
+	{
+		loadPage(0, 0, true);
+		clampFramePoints();
+	}
+}
+
+void Buffer::pageToEnd()
+{
+	if (!isPaged() || pagedEndOffset == pagedFile->getSize())
+	{
+		return;
+	}
+
+	// NOTE(fkp): One less because of the empty line at the end
+	std::uint64_t startOffset;
+	pagedFile->findStartOfPreviousLines(pagedFile->getSize(), PAGED_WINDOW_NUMBER_OF_LINES - 1, startOffset);
+	loadPage(startOffset, 0, false);
+
+	if (pagedFile->isIndexComplete())
+	{
+		firstPagedLine = pagedFile->getNumberOfLines() - data.size();
+		isFirstPagedLineKnown = true;
+	}
+
+	clampFramePoints();
+}
+
+// The line number of the start of the window isn't known after
+// jumping somewhere the index hasn't got to yet.
+bool Buffer::getFirstPagedLine(std::uint64_t& line)
+{
+	if (!isFirstPagedLineKnown && pagedFile->getLineAtOffset(pagedLineOffsets[0], firstPagedLine))
+	{
+		isFirstPagedLineKnown = true;
+	}
+
+	line = firstPagedLine;
+	return isFirstPagedLineKnown;
+}
+
+void Buffer::clampFramePoints()
+{
+	unsigned int lastLine = data.size() - 1;
+
+	for (Frame* frame : *Frame::allFrames)
+	{
+		if (frame->currentBuffer != this)
+		{
+			continue;
+		}
+
+		frame->currentTopLine = std::min(frame->currentTopLine, (int) lastLine);
+		frame->targetTopLine = std::min(frame->targetTopLine, (int) lastLine);
+	}
+
+	anchors.forEach([&](Point& point)
+					{
+						point.line = std::min(point.line, lastLine);
+						point.col = std::min<unsigned int>(point.col, data[point.line].size());
+					});
+	lastTopLine = std::min(lastTopLine, lastLine);
+}
+
+std::string substrFromPoints(const std::string& string, const Point& start, const Point& end, unsigned int lineOffset)
+{
+	if (start > end)
+	{
+		ERROR_ONCE("Error: Start cannot be after end in substr.\n");
+		return "";
+	}
+
+	if (lineOffset > start.line)
+	{
+		ERROR_ONCE("Error: String starts after the requested start point in substr.\n");
+		return "";
+	}
+	
+	unsigned int startIndex = 0;
+	unsigned int currentIndex = 0;
+	unsigned int linesPassed = lineOffset;
+	
+	while (currentIndex < string.size() && linesPassed < start.line)
+	{
+		if (string[currentIndex] == '\n')
+		{
+			linesPassed += 1;
+		}
+
+		currentIndex += 1;
+	}
+
+	currentIndex += start.col;
+	startIndex = currentIndex;
+	linesPassed = 0;
+	unsigned int length = 0;
+
+	while (currentIndex < string.size() && linesPassed < end.line - start.line)
+	{
+		if (string[currentIndex] == '\n')
+		{
+			linesPassed += 1;
+		}
+
+		length += 1;
+		currentIndex += 1;
+	}
+
+	// The final line
+	if (start.line == end.line)
+	{
+		length += end.col - start.col;
+	}
+	else
+	{
+		length += end.col;
+	}
+
+	return string.substr(startIndex, length);
+}
+
+Point getPointAfterText(const Point& start, const std::string& text)
+{
+	Point result = start;
+
+	for (char character : text)
+	{
+		if (character == '\n')
+		{
+			result.line += 1;
+			result.col = 0;
+		}
+		else if (character != '\r')
+		{
+			result.col += 1;
+		}
+	}
+
+	return result;
 }
 
 Point getPointAtEndOfString(const std::string& string, unsigned int lineOffset)
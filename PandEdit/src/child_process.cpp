@@ -0,0 +1,138 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <stdio.h>
+#include <initializer_list>
+#include <vector>
+
+#include "child_process.hpp"
+
+static void closeHandles(std::initializer_list<HANDLE> handles)
+{
+	for (HANDLE handle : handles)
+	{
+		if (handle)
+		{
+			CloseHandle(handle);
+		}
+	}
+}
+
+bool startChildProcess(const std::string& command, ChildProcess& childProcess, bool shouldStartInJob)
+{
+	// Makes the command a modifiable char* because Windows wants that
+	// for some reason
+	std::vector<char> commandCStr(command.begin(), command.end());
+	commandCStr.push_back('\0');
+	
+	//
+	// NOTE(fkp): Pipe setup
+	//
+	
+	HANDLE childStdOutRead = nullptr;
+	HANDLE childStdOutWrite = nullptr;
+	HANDLE childStdInRead = nullptr;
+	HANDLE childStdInWrite = nullptr;
+	
+	SECURITY_ATTRIBUTES securityAttributes {};
+	securityAttributes.nLength = sizeof(securityAttributes);
+	securityAttributes.bInheritHandle = true;
+	securityAttributes.lpSecurityDescriptor = nullptr;
+
+ 	// Create a pipe for the child process's STDOUT
+	if (!CreatePipe(&childStdOutRead, &childStdOutWrite, &securityAttributes, 0))
+	{
+		printf("Error: Failed to create child process's STDOUT handle.\n");
+		return false;
+	}
+
+	// Ensure child's STDOUT read handle is not inherited
+	if (!SetHandleInformation(childStdOutRead, HANDLE_FLAG_INHERIT, 0))
+	{
+		printf("Error: Failed to ensure child process's STDOUT read handle is not inherited.\n");
+		closeHandles({ childStdOutRead, childStdOutWrite });
+		return false;
+	}
+
+ 	// Create a pipe for the child process's STDIN
+	if (!CreatePipe(&childStdInRead, &childStdInWrite, &securityAttributes, 0))
+	{
+		printf("Error: Failed to create child process's STDIN handle.\n");
+		closeHandles({ childStdOutRead, childStdOutWrite });
+		return false;
+	}
+
+	// Ensure child's STDIN write handle is not inherited
+	if (!SetHandleInformation(childStdInWrite, HANDLE_FLAG_INHERIT, 0))
+	{
+		printf("Error: Failed to ensure child process's STDIN write handle is not inherited.\n");
+		closeHandles({ childStdOutRead, childStdOutWrite, childStdInRead, childStdInWrite });
+		return false;
+	}
+
+	//
+	// NOTE(fkp): Job setup
+	//
+
+	HANDLE job = nullptr;
+
+	if (shouldStartInJob)
+	{
+		job = CreateJobObjectA(nullptr, nullptr);
+		JOBOBJECT_EXTENDED_LIMIT_INFORMATION limitInformation {};
+		limitInformation.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+
+		if (!job || !SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limitInformation, sizeof(limitInformation)))
+		{
+			printf("Error: Failed to create child process's job.\n");
+			closeHandles({ childStdOutRead, childStdOutWrite, childStdInRead, childStdInWrite, job });
+			return false;
+		}
+	}
+
+	//
+	// NOTE(fkp): Process creation
+	//
+
+	PROCESS_INFORMATION processInformation {};
+	STARTUPINFO startupInfo {};
+	startupInfo.cb = sizeof(startupInfo);
+	startupInfo.hStdError = childStdOutWrite;
+	startupInfo.hStdOutput = childStdOutWrite;
+	startupInfo.hStdInput = childStdInRead;
+	startupInfo.dwFlags = STARTF_USESTDHANDLES;
+
+	// It's started suspended when in a job, so it can't start anything
+	// else before it's been put in the job.
+	if (!CreateProcess(nullptr, commandCStr.data(),
+					   nullptr, nullptr, true, job ? CREATE_SUSPENDED : 0, nullptr, nullptr,
+					   &startupInfo, &processInformation))
+	{
+		printf("Error: Failed to create child process.\n");
+		closeHandles({ childStdOutRead, childStdOutWrite, childStdInRead, childStdInWrite, job });
+		return false;
+	}
+
+	if (job)
+	{
+		if (!AssignProcessToJobObject(job, processInformation.hProcess))
+		{
+			printf("Error: Failed to put child process in its job.\n");
+			TerminateProcess(processInformation.hProcess, 1);
+			closeHandles({ processInformation.hProcess, processInformation.hThread, childStdOutRead, childStdOutWrite, childStdInRead, childStdInWrite, job });
+			return false;
+		}
+
+		ResumeThread(processInformation.hThread);
+	}
+
+	// Closes the handles only the child needs, otherwise reading its
+	// STDOUT would never finish.
+	closeHandles({ processInformation.hThread, childStdOutWrite, childStdInRead });
+
+	childProcess.process = processInformation.hProcess;
+	childProcess.stdInWrite = childStdInWrite;
+	childProcess.stdOutRead = childStdOutRead;
+	childProcess.job = job;
+
+	return true;
+}
@@ -3,10 +3,11 @@
 #include "commands.hpp"
 #include "frame.hpp"
 #include "window.hpp"
+#include "keyboard_macro.hpp"
 
 void writeToMinibuffer(std::string message)
 {
-	Frame::minibufferFrame->currentBuffer->data[0] = message;
+	Frame::minibufferFrame->currentBuffer->data.setLine(0, message);
 	Frame::minibufferFrame->point.col = Frame::minibufferFrame->currentBuffer->data[0].size();
 }
 
@@ -55,6 +56,28 @@ std::unordered_map<std::string, COMMAND_FUNC_SIG()> Commands::essentialCommandsM
 	
 	COMMAND(setMark),
 	COMMAND(swapPointAndMark),
+
+	COMMAND(addCursorToNextOccurrence),
+	COMMAND(addCursorsToRegionLines),
+	COMMAND(clearCursors),
+
+	COMMAND(startMacro),
+	COMMAND(endMacro),
+	COMMAND(replayMacro),
+	COMMAND(replayMacroOnRegionLines),
+
+	COMMAND(sortRegionLines),
+	COMMAND(uniqueRegionLines),
+	COMMAND(reverseRegionLines),
+	COMMAND(trimRegionWhitespace),
+	COMMAND(alignRegionLines),
+	COMMAND(copyRectangle),
+	COMMAND(killRectangle),
+	COMMAND(yankRectangle),
+	COMMAND(insertRectangle),
+	COMMAND(replaceRectangle),
+	COMMAND(shellCommandOnRegion),
+	COMMAND(cancelShellCommand),
 	
 	COMMAND(pageUp),
 	COMMAND(pageDown),
@@ -76,6 +99,7 @@ std::unordered_map<std::string, COMMAND_FUNC_SIG()> Commands::nonEssentialComman
 	COMMAND(echo),
 	COMMAND(minibufferEnter),
 	COMMAND(toggleOverwriteMode),
+	COMMAND(searchForward),
 
 	COMMAND(frameSplitVertically),
 	COMMAND(frameSplitHorizontally),
@@ -86,9 +110,20 @@ std::unordered_map<std::string, COMMAND_FUNC_SIG()> Commands::nonEssentialComman
 	COMMAND(switchToBuffer),
 	COMMAND(destroyBuffer),
 	COMMAND(findFile),
+	COMMAND(findFileMapped),
+	COMMAND(findFilePaged),
 	COMMAND(saveCurrentBuffer),
 	COMMAND(saveAllBuffers),
 	COMMAND(revertBuffer),
+	COMMAND(benchmarkFileLoad),
+	COMMAND(benchmarkLexer),
+	COMMAND(checkLexerScanning),
+	COMMAND(benchmarkUndo),
+	COMMAND(showBufferStats),
+	COMMAND(internBufferLines),
+	COMMAND(switchUndoBranch),
+	COMMAND(showUndoStats),
+	COMMAND(setUndoMemoryBudget),
 
 	{ "lexBufferAsC++", lexBufferAsCpp },
 
@@ -101,6 +136,8 @@ std::unordered_map<std::string, COMMAND_FUNC_SIG()> Commands::nonEssentialComman
 
 void Commands::executeCommand(Window& window, const std::string& commandText, bool shortcut)
 {	
+	KeyboardMacro::recordCommand(commandText, shortcut);
+
 	std::string commandName = commandText.substr(0, commandText.find(' '));
 	std::string argumentsText = "";
 
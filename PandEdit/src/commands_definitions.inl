@@ -2,10 +2,14 @@
 // commands.cpp
 
 #include <fstream>
+#include <unordered_set>
 
 #include "file_util.hpp"
 #include "renderer.hpp"
 #include "lexer.hpp"
+#include "timer.hpp"
+#include "keyboard_macro.hpp"
+#include "region_transforms.hpp"
 
 #define DEFINE_COMMAND(name) bool name(Window& window, const std::string& text)
 #define FRAME Frame::currentFrame
@@ -57,10 +61,17 @@ DEFINE_COMMAND(quit)
 		case 'y':
 		{
 			saveAllBuffers(window, text);
+			Buffer::finishAllSaves();
 		} // no break
 
 		case 'n':
 		{
+			// Quitting without saving throws the edits away
+			if (text.back() == 'n')
+			{
+				Buffer::discardAllJournals();
+			}
+			
 			window.isOpen = false;
 		} return true;;
 
@@ -346,6 +357,353 @@ DEFINE_COMMAND(swapPointAndMark)
 	return false;
 }
 
+DEFINE_COMMAND(addCursorToNextOccurrence)
+{
+	exitMinibuffer("");
+	auto startAndEnd = FRAME->getPointStartAndEnd();
+	Point start = startAndEnd.first;
+	Point end = startAndEnd.second;
+
+	if (start.line != end.line || start.col == end.col)
+	{
+		writeToMinibuffer("Mark some text on one line to look for.");
+		return false;
+	}
+
+	std::string searchText = FRAME->getTextPointToMark();
+	bool isPointAtEnd = !(FRAME->point < end);
+
+	// Carries on from the last occurrence that has a cursor
+	Point searchFrom = end;
+
+	for (const std::unique_ptr<Point>& cursor : FRAME->cursors)
+	{
+		Point occurrenceEnd { cursor->line, cursor->col + (isPointAtEnd ? 0 : (unsigned int) searchText.size()) };
+
+		if (searchFrom < occurrenceEnd)
+		{
+			searchFrom = occurrenceEnd;
+		}
+	}
+
+	for (unsigned int line = searchFrom.line; line < BUFFER->data.size(); line++)
+	{
+		std::string_view::size_type col = BUFFER->data[line].find(searchText, line == searchFrom.line ? searchFrom.col : 0);
+
+		if (col != std::string_view::npos)
+		{
+			FRAME->addCursor(Point { line, (unsigned int) col + (isPointAtEnd ? (unsigned int) searchText.size() : 0) });
+
+			char message[64];
+			snprintf(message, sizeof(message), "%u cursors.", (unsigned int) FRAME->cursors.size() + 1);
+			writeToMinibuffer(message);
+
+			return false;
+		}
+	}
+
+	writeToMinibuffer("No more occurrences.");
+	return false;
+}
+
+DEFINE_COMMAND(addCursorsToRegionLines)
+{
+	exitMinibuffer("");
+	auto startAndEnd = FRAME->getPointStartAndEnd();
+
+	for (unsigned int line = startAndEnd.first.line; line <= startAndEnd.second.line; line++)
+	{
+		if (line != FRAME->point.line)
+		{
+			FRAME->addCursor(Point { line, std::min<unsigned int>(FRAME->point.col, BUFFER->data[line].size()) });
+		}
+	}
+
+	FRAME->removeDuplicateCursors();
+
+	char message[64];
+	snprintf(message, sizeof(message), "%u cursors.", (unsigned int) FRAME->cursors.size() + 1);
+	writeToMinibuffer(message);
+
+	return false;
+}
+
+DEFINE_COMMAND(clearCursors)
+{
+	exitMinibuffer("");
+	FRAME->clearCursors();
+	return false;
+}
+
+DEFINE_COMMAND(startMacro)
+{
+	exitMinibuffer("Recording macro...");
+	KeyboardMacro::start();
+
+	return true;
+}
+
+DEFINE_COMMAND(endMacro)
+{
+	bool wasEndedFromMinibuffer = Frame::currentFrame == Frame::minibufferFrame;
+
+	if (!KeyboardMacro::end(wasEndedFromMinibuffer))
+	{
+		exitMinibuffer("Not recording a macro.");
+		return true;
+	}
+
+	char message[64];
+	snprintf(message, sizeof(message), "Recorded macro (%u steps).", KeyboardMacro::getNumberOfSteps());
+	exitMinibuffer(message);
+
+	return true;
+}
+
+static void writeMacroReplayRate(std::size_t numberOfStepsRun, double elapsedMs)
+{
+	char message[128];
+	snprintf(message, sizeof(message), "Replayed %zu macro steps in %.1fms (%.0f steps/s).",
+			 numberOfStepsRun, elapsedMs, elapsedMs > 0.0 ? numberOfStepsRun * 1000.0 / elapsedMs : 0.0);
+	writeToMinibuffer(message);
+}
+
+DEFINE_COMMAND(replayMacro)
+{
+	// The number of times can come after the command
+	char* end;
+	unsigned long numberOfTimes = text == "" ? 1 : strtoul(text.c_str(), &end, 10);
+
+	if (text != "" && (*end != '\0' || numberOfTimes == 0))
+	{
+		exitMinibuffer("Error: Expected the number of times to replay the macro.");
+		return true;
+	}
+
+	exitMinibuffer("");
+
+	if (KeyboardMacro::isRecording || KeyboardMacro::getNumberOfSteps() == 0)
+	{
+		writeToMinibuffer("No macro to replay.");
+		return true;
+	}
+
+	Timer timer;
+	std::size_t numberOfStepsRun = KeyboardMacro::replay(window, (unsigned int) numberOfTimes);
+	writeMacroReplayRate(numberOfStepsRun, timer.getElapsedMs());
+
+	return true;
+}
+
+DEFINE_COMMAND(replayMacroOnRegionLines)
+{
+	exitMinibuffer("");
+
+	if (KeyboardMacro::isRecording || KeyboardMacro::getNumberOfSteps() == 0)
+	{
+		writeToMinibuffer("No macro to replay.");
+		return true;
+	}
+
+	// A region that ends at the start of a line doesn't include it
+	auto startAndEnd = FRAME->getPointStartAndEnd();
+	unsigned int firstLine = startAndEnd.first.line;
+	unsigned int lastLine = startAndEnd.second.line;
+
+	if (lastLine > firstLine && startAndEnd.second.col == 0)
+	{
+		lastLine -= 1;
+	}
+
+	Timer timer;
+	std::size_t numberOfStepsRun = KeyboardMacro::replayOnLines(window, firstLine, lastLine);
+	writeMacroReplayRate(numberOfStepsRun, timer.getElapsedMs());
+
+	return true;
+}
+
+// Replaces the lines of the region with what the transform makes of them
+template<typename Function>
+static void transformRegionLines(const char* verb, Function transform)
+{
+	if (!FRAME->warnIfBufferIsReadOnly()) return;
+
+	// A region that ends at the start of a line doesn't include it
+	auto startAndEnd = FRAME->getPointStartAndEnd();
+	unsigned int firstLine = startAndEnd.first.line;
+	unsigned int lastLine = startAndEnd.second.line;
+
+	if (lastLine > firstLine && startAndEnd.second.col == 0)
+	{
+		lastLine -= 1;
+	}
+
+	Timer timer;
+	std::string regionText = BUFFER->substrFromPoints(Point { firstLine, 0 }, Point { lastLine, (unsigned int) BUFFER->data[lastLine].size() });
+	std::vector<std::string_view> lines = splitIntoLines(regionText);
+	unsigned int numberOfLines = (unsigned int) lines.size();
+
+	transform(lines);
+	std::string newText = joinWithNewlines(lines);
+
+	if (newText != regionText)
+	{
+		FRAME->beginTransaction();
+		BUFFER->replaceLines(firstLine, lastLine, newText);
+		FRAME->point.targetCol = FRAME->point.col;
+		FRAME->doCommonPointManipulationTasks();
+		FRAME->commitTransaction();
+	}
+
+	char message[128];
+	snprintf(message, sizeof(message), "%s %u lines (%u left) in %.1fms.", verb, numberOfLines, (unsigned int) lines.size(), timer.getElapsedMs());
+	writeToMinibuffer(message);
+}
+
+DEFINE_COMMAND(sortRegionLines)
+{
+	exitMinibuffer("");
+	transformRegionLines("Sorted", [](std::vector<std::string_view>& lines) { sortLines(lines); });
+
+	return true;
+}
+
+DEFINE_COMMAND(uniqueRegionLines)
+{
+	exitMinibuffer("");
+	transformRegionLines("Deduplicated", [](std::vector<std::string_view>& lines) { uniqueLines(lines); });
+
+	return true;
+}
+
+DEFINE_COMMAND(reverseRegionLines)
+{
+	exitMinibuffer("");
+	transformRegionLines("Reversed", [](std::vector<std::string_view>& lines) { reverseLines(lines); });
+
+	return true;
+}
+
+DEFINE_COMMAND(trimRegionWhitespace)
+{
+	exitMinibuffer("");
+	transformRegionLines("Trimmed", [](std::vector<std::string_view>& lines) { trimTrailingWhitespace(lines); });
+
+	return true;
+}
+
+DEFINE_COMMAND(alignRegionLines)
+{
+	// The delimiter can come after the command, '=' by default
+	std::string delimiter = text != "" ? text : "=";
+	std::vector<std::string> alignedLines;
+
+	exitMinibuffer("");
+	transformRegionLines("Aligned", [&](std::vector<std::string_view>& lines) { alignLines(lines, delimiter, alignedLines); });
+
+	return true;
+}
+
+DEFINE_COMMAND(copyRectangle)
+{
+	exitMinibuffer("");
+	FRAME->copyRectangle(tabWidth);
+	writeToMinibuffer("Copied a rectangle of " + std::to_string(Frame::killedRectangle.size()) + " lines.");
+
+	return true;
+}
+
+DEFINE_COMMAND(killRectangle)
+{
+	Timer timer;
+
+	exitMinibuffer("");
+	if (!FRAME->warnIfBufferIsReadOnly()) return true;
+	FRAME->copyRectangle(tabWidth, true);
+
+	char message[128];
+	snprintf(message, sizeof(message), "Killed a rectangle of %u lines in %.1fms.", (unsigned int) Frame::killedRectangle.size(), timer.getElapsedMs());
+	writeToMinibuffer(message);
+
+	return true;
+}
+
+DEFINE_COMMAND(yankRectangle)
+{
+	exitMinibuffer("");
+	FRAME->yankRectangle(tabWidth);
+
+	return true;
+}
+
+// The text comes after the command, and goes in front of the rectangle
+DEFINE_COMMAND(insertRectangle)
+{
+	std::string string = text;
+	Timer timer;
+
+	exitMinibuffer("");
+	if (!FRAME->warnIfBufferIsReadOnly()) return true;
+	FRAME->stringRectangle(string, tabWidth, false);
+
+	char message[128];
+	snprintf(message, sizeof(message), "Inserted into %u lines in %.1fms.", std::max(FRAME->point.line, FRAME->mark.line) - std::min(FRAME->point.line, FRAME->mark.line) + 1, timer.getElapsedMs());
+	writeToMinibuffer(message);
+
+	return true;
+}
+
+// The text comes after the command, and goes in place of the rectangle
+DEFINE_COMMAND(replaceRectangle)
+{
+	std::string string = text;
+
+	exitMinibuffer("");
+	FRAME->stringRectangle(string, tabWidth, true);
+
+	return true;
+}
+
+// The command comes after the name, and its output replaces the region
+DEFINE_COMMAND(shellCommandOnRegion)
+{
+	std::string command = text;
+
+	exitMinibuffer("");
+	if (!FRAME->warnIfBufferIsReadOnly()) return true;
+
+	if (command == "")
+	{
+		writeToMinibuffer("Error: No shell command given.");
+		return true;
+	}
+
+	auto startAndEnd = FRAME->getPointStartAndEnd();
+
+	if (BUFFER->startShellFilter(command, startAndEnd.first, startAndEnd.second))
+	{
+		writeToMinibuffer("Running \"" + command + "\" on the region...");
+	}
+
+	return true;
+}
+
+DEFINE_COMMAND(cancelShellCommand)
+{
+	exitMinibuffer("");
+
+	if (BUFFER->isRunningShellFilter())
+	{
+		BUFFER->cancelShellFilter();
+	}
+	else
+	{
+		writeToMinibuffer("No shell command is running in this buffer.");
+	}
+
+	return true;
+}
+
 DEFINE_COMMAND(pageUp)
 {
 	// Minibuffer shouldn't have scrolling
@@ -379,6 +737,52 @@ DEFINE_COMMAND(centerPoint)
 	return false;
 }
 
+DEFINE_COMMAND(searchForward)
+{
+	static std::string lastSearchText = "";
+
+	if (Commands::currentCommand)
+	{
+		Commands::currentCommand = nullptr;
+		exitMinibuffer("");
+
+		// Searching for nothing repeats the last search
+		if (text != "")
+		{
+			lastSearchText = text;
+		}
+
+		Point result;
+
+		if (lastSearchText == "")
+		{
+			writeToMinibuffer("Error: Nothing to search for.");
+		}
+		else if (BUFFER->findText(FRAME->point, lastSearchText, result))
+		{
+			FRAME->point.line = result.line;
+			FRAME->point.col = result.col;
+			FRAME->point.targetCol = result.col;
+			FRAME->doCommonPointManipulationTasks();
+		}
+		else
+		{
+			writeToMinibuffer("Search failed: '" + lastSearchText + "'");
+		}
+
+		return true;
+	}
+	else
+	{
+		Frame::minibufferFrame->makeActive();
+		Commands::currentCommand = searchForward;
+		Commands::currentlyReading = MinibufferReading::SearchText;
+		writeToMinibuffer("Search: ");
+
+		return false;
+	}
+}
+
 
 //
 // NOTE(fkp): Copy/cut/paste/undo/redo
@@ -414,7 +818,12 @@ DEFINE_COMMAND(deleteRegion)
 
 DEFINE_COMMAND(undo)
 {
-	if (!BUFFER->undo(*FRAME) && BUFFER->type != BufferType::MiniBuffer)
+	if (BUFFER->undo(FRAME->point))
+	{
+		FRAME->point.targetCol = FRAME->point.col;
+		FRAME->doCommonPointManipulationTasks();
+	}
+	else if (BUFFER->type != BufferType::MiniBuffer)
 	{
 		writeToMinibuffer("Nothing to undo.");
 	}
@@ -424,7 +833,12 @@ DEFINE_COMMAND(undo)
 
 DEFINE_COMMAND(redo)
 {
-	if (!BUFFER->redo(*FRAME) && BUFFER->type != BufferType::MiniBuffer)
+	if (BUFFER->redo(FRAME->point))
+	{
+		FRAME->point.targetCol = FRAME->point.col;
+		FRAME->doCommonPointManipulationTasks();
+	}
+	else if (BUFFER->type != BufferType::MiniBuffer)
 	{
 		writeToMinibuffer("Nothing to redo.");
 	}
@@ -432,6 +846,59 @@ DEFINE_COMMAND(redo)
 	return false;	
 }
 
+DEFINE_COMMAND(switchUndoBranch)
+{
+	exitMinibuffer("");
+
+	unsigned int branchIndex;
+	unsigned int numberOfBranches = BUFFER->undoTree.switchBranch(branchIndex);
+
+	if (numberOfBranches == 0)
+	{
+		writeToMinibuffer("Nothing to redo.");
+	}
+	else
+	{
+		writeToMinibuffer("Redo branch " + std::to_string(branchIndex + 1) + " of " + std::to_string(numberOfBranches) + ".");
+	}
+
+	return false;
+}
+
+DEFINE_COMMAND(showUndoStats)
+{
+	exitMinibuffer("");
+
+	UndoTree::Stats stats = BUFFER->undoTree.getStats();
+
+	char message[256];
+	snprintf(message, sizeof(message), "Undo depth %u, %u actions, %u branch points, %.1fKB in memory (budget %.1fMB), %u compressed, %u spilled (%.1fKB on disk)",
+			 stats.depth, stats.numberOfActions, stats.numberOfBranches, stats.numberOfBytesInMemory / 1024.0,
+			 UndoTree::memoryBudget / (1024.0 * 1024.0), stats.numberOfCompressedActions,
+			 stats.numberOfSpilledActions, stats.numberOfBytesSpilled / 1024.0);
+	writeToMinibuffer(message);
+
+	return true;
+}
+
+DEFINE_COMMAND(setUndoMemoryBudget)
+{
+	// The budget is in megabytes, and is for each buffer
+	char* end;
+	double megabytes = strtod(text.c_str(), &end);
+
+	if (text == "" || *end != '\0' || megabytes < 0.0)
+	{
+		exitMinibuffer("Error: Expected the undo memory budget in MB.");
+		return true;
+	}
+
+	UndoTree::memoryBudget = (std::size_t) (megabytes * 1024.0 * 1024.0);
+	exitMinibuffer("Undo memory budget is now " + text + "MB per buffer.");
+
+	return true;
+}
+
 
 //
 // NOTE(fkp): Buffer commands
@@ -503,6 +970,10 @@ DEFINE_COMMAND(destroyBuffer)
 }
 
 // TODO(fkp): This command is very similar to switchToBuffer.
+// NOTE(fkp): Set by findFileMapped/findFilePaged for the rest of the
+// path prompt
+static FileOpenMode nextFileOpenMode = FileOpenMode::Normal;
+
 DEFINE_COMMAND(findFile)
 {
 	if (Commands::currentCommand)
@@ -524,7 +995,7 @@ DEFINE_COMMAND(findFile)
 				if (!buffer)
 				{
 					std::string filename = getFilenameFromPath(text.substr(0, text.find(' ')));
-					buffer = new Buffer { BufferType::Text, filename, text.substr(0, text.find(' ')) };
+					buffer = new Buffer { BufferType::Text, filename, text.substr(0, text.find(' ')), nextFileOpenMode };
 				}
 
 				FRAME->switchToBuffer(buffer);
@@ -533,7 +1004,7 @@ DEFINE_COMMAND(findFile)
 			else
 			{
 				Commands::currentlyReading = MinibufferReading::Confirmation;
-				BUFFER->data[0] += " [create? y/n] ";
+				BUFFER->data.insertText(0, BUFFER->data[0].size(), " [create? y/n] ");
 				FRAME->point.col = BUFFER->data[0].size();
 				FRAME->popupLines.clear();
 
@@ -547,7 +1018,7 @@ DEFINE_COMMAND(findFile)
 				// This is the same as above
 				std::string path = text.substr(0, text.find_last_of("["));
 				std::string filename = getFilenameFromPath(path);
-				Buffer* buffer = new Buffer { BufferType::Text, filename, path };
+				Buffer* buffer = new Buffer { BufferType::Text, filename, path, nextFileOpenMode };
 
 				Commands::currentCommand = nullptr;
 				exitMinibuffer("");
@@ -561,7 +1032,7 @@ DEFINE_COMMAND(findFile)
 				
 				// The +6 is for the "Path: " at the start of the string
 				// The -1 is because we want to at the space before the bracket
-				BUFFER->data[0] = BUFFER->data[0].substr(0, text.find_last_of("[") + 6 - 1);
+				BUFFER->data.setLine(0, BUFFER->data[0].substr(0, text.find_last_of("[") + 6 - 1));
 				FRAME->point.col = BUFFER->data[0].size();
 				FRAME->updatePopups();
 				
@@ -578,12 +1049,41 @@ DEFINE_COMMAND(findFile)
 	{
 		Frame::minibufferFrame->makeActive();
 		Commands::currentCommand = findFile;
+		nextFileOpenMode = FileOpenMode::Normal;
 		startReadingPath(window);
 
 		return false;
 	}
 }
 
+// Opens the file as a read-only mapping, lines are only copied into
+// memory when they are edited.
+DEFINE_COMMAND(findFileMapped)
+{
+	bool result = findFile(window, text);
+
+	if (Commands::currentCommand == findFile)
+	{
+		nextFileOpenMode = FileOpenMode::Mapped;
+	}
+
+	return result;
+}
+
+// Opens the file read-only with only a window of lines in memory, for
+// files that are too large to load at all.
+DEFINE_COMMAND(findFilePaged)
+{
+	bool result = findFile(window, text);
+
+	if (Commands::currentCommand == findFile)
+	{
+		nextFileOpenMode = FileOpenMode::Paged;
+	}
+
+	return result;
+}
+
 bool saveBuffer(Buffer* buffer, COMMAND_FUNC_SIG(commandName), Window& window, const std::string& text, bool requestPath)
 {
 	if (Commands::currentCommand == commandName && requestPath)
@@ -607,7 +1107,7 @@ bool saveBuffer(Buffer* buffer, COMMAND_FUNC_SIG(commandName), Window& window, c
 			}
 
 			buffer->saveToFile();
-			writeToMinibuffer("Saved \"" + buffer->path + "\"");
+			writeToMinibuffer("Saving \"" + buffer->path + "\"...");
 		}
 		
 		return true;
@@ -618,7 +1118,7 @@ bool saveBuffer(Buffer* buffer, COMMAND_FUNC_SIG(commandName), Window& window, c
 		{
 			exitMinibuffer("");
 			buffer->saveToFile();
-			writeToMinibuffer("Saved \"" + buffer->path + "\"");
+			writeToMinibuffer("Saving \"" + buffer->path + "\"...");
 		
 			return true;
 		}
@@ -645,9 +1145,15 @@ DEFINE_COMMAND(saveCurrentBuffer)
 DEFINE_COMMAND(saveAllBuffers)
 {
 	// NOTE(fkp): This won't actually ask for a path, but will save
-	// all file-visiting buffers.
+	// all file-visiting buffers that have changed. They are all written
+	// at the same time.
 	for (auto& bufferElement : Buffer::buffersMap)
 	{
+		if (bufferElement.second->numberOfActionsSinceSave == 0)
+		{
+			continue;
+		}
+		
 		saveBuffer(bufferElement.second, saveAllBuffers, window, text, false);
 	}
 
@@ -662,11 +1168,363 @@ DEFINE_COMMAND(revertBuffer)
 	return true;
 }
 
+// NOTE(fkp): This is how files used to be loaded (line by line, then
+// split again), it's only kept around to compare against.
+static std::vector<std::string> loadFileLineByLine(const std::string& path)
+{
+	std::ifstream file(path);
+	std::string contents;
+	std::string line;
+
+	while (std::getline(file, line))
+	{
+		contents += line + '\n';
+	}
+
+	std::vector<std::string> lines;
+	std::size_t lineStart = 0;
+	std::size_t lineEnd;
+
+	while ((lineEnd = contents.find("\n", lineStart)) != std::string::npos)
+	{
+		lines.push_back(contents.substr(lineStart, lineEnd - lineStart));
+		lineStart = lineEnd + 1;
+	}
+
+	lines.push_back(contents.substr(lineStart));
+	return lines;
+}
+
+DEFINE_COMMAND(benchmarkFileLoad)
+{
+	// NOTE(fkp): The text is the minibuffer's, so it has to be copied first
+	std::string path = text;
+	exitMinibuffer("");
+
+	if (path == "")
+	{
+		path = BUFFER->path;
+	}
+
+	if (path == "" || !doesFileExist(path.c_str()))
+	{
+		writeToMinibuffer("Error: No file to benchmark loading.");
+		return true;
+	}
+
+	Timer timer;
+	std::vector<std::string> oldLines = loadFileLineByLine(path);
+	double oldMs = timer.getElapsedMs();
+
+	timer.reset();
+	std::string contents = readFile(path.c_str());
+	std::size_t numberOfBytes = contents.size();
+	PieceTable newLines;
+	newLines.loadFromString(std::move(contents));
+	double newMs = timer.getElapsedMs();
+
+	if (oldLines.size() != newLines.size())
+	{
+		printf("Error: Old and new loading gave %zu and %u lines.\n", oldLines.size(), newLines.size());
+	}
+
+	double megabytes = (double) numberOfBytes / (1024.0 * 1024.0);
+	char message[256];
+	snprintf(message, sizeof(message), "Loaded %.1fMB: old %.1fMB/s (%.0fms), new %.1fMB/s (%.0fms)",
+			 megabytes, megabytes / (oldMs / 1000.0), oldMs, megabytes / (newMs / 1000.0), newMs);
+	writeToMinibuffer(message);
+
+	return true;
+}
+
+DEFINE_COMMAND(benchmarkLexer)
+{
+	exitMinibuffer("");
+
+	Point end { BUFFER->data.size() - 1, (unsigned int) BUFFER->data[BUFFER->data.size() - 1].size(), BUFFER };
+	std::string contents = BUFFER->substrFromPoints(Point { 0, 0, BUFFER }, end);
+
+	// NOTE(fkp): This lexes a copy so the buffer's own tokens are left alone
+	Buffer snapshot { BufferType::Snapshot, "", "" };
+	snapshot.data.loadFromString(std::string(contents));
+	snapshot.lexer.lineStates.resize(snapshot.data.size());
+
+	Timer timer;
+	snapshot.lexer.lex(0, false, true);
+	double lexMs = std::max(timer.getElapsedMs(), 0.001);
+
+	std::size_t numberOfTokens = 0;
+
+	for (const LineLexState& lineState : snapshot.lexer.lineStates)
+	{
+		numberOfTokens += lineState.tokens.size();
+	}
+
+	// Times just the identifier classification, the old way (copying each
+	// one into a string and looking it up in two sets) against the new one.
+	std::vector<std::string_view> identifiers;
+
+	for (std::size_t i = 0; i < contents.size();)
+	{
+		auto isIdentifierCharacter = [](char character)
+									 {
+										 return isalnum((unsigned char) character) || character == '_';
+									 };
+
+		if (!isIdentifierCharacter(contents[i]))
+		{
+			i += 1;
+			continue;
+		}
+
+		std::size_t start = i;
+
+		while (i < contents.size() && isIdentifierCharacter(contents[i]))
+		{
+			i += 1;
+		}
+
+		if (!isdigit((unsigned char) contents[start]))
+		{
+			identifiers.emplace_back(contents.data() + start, i - start);
+		}
+	}
+
+	if (identifiers.empty())
+	{
+		writeToMinibuffer("Error: No identifiers in the buffer to benchmark.");
+		return true;
+	}
+
+	std::unordered_set<std::string> oldKeywords;
+	std::unordered_set<std::string> oldPrimitiveTypes;
+
+	for (std::string_view keyword : KEYWORDS)
+	{
+		oldKeywords.emplace(keyword);
+	}
+
+	for (std::string_view type : PRIMITIVE_TYPES)
+	{
+		oldPrimitiveTypes.emplace(type);
+	}
+
+	std::size_t oldMatches = 0;
+	timer.reset();
+
+	for (std::string_view identifier : identifiers)
+	{
+		std::string tokenText;
+
+		for (char character : identifier)
+		{
+			tokenText += character;
+		}
+
+		if (oldKeywords.find(tokenText) != oldKeywords.end() ||
+			oldPrimitiveTypes.find(tokenText) != oldPrimitiveTypes.end())
+		{
+			oldMatches += 1;
+		}
+	}
+
+	double oldMs = std::max(timer.getElapsedMs(), 0.001);
+	std::size_t newMatches = 0;
+	timer.reset();
+
+	for (std::string_view identifier : identifiers)
+	{
+		if (classifyKeyword(identifier) != KeywordType::None)
+		{
+			newMatches += 1;
+		}
+	}
+
+	double newMs = std::max(timer.getElapsedMs(), 0.001);
+
+	if (oldMatches != newMatches)
+	{
+		printf("Error: Old and new keyword lookups found %zu and %zu keywords.\n", oldMatches, newMatches);
+	}
+
+	char message[256];
+	snprintf(message, sizeof(message), "Lexed %u lines, %zu tokens in %.0fms (%.2fM tokens/s), identifiers: old %.1fM/s, new %.1fM/s",
+			 snapshot.data.size(), numberOfTokens, lexMs, numberOfTokens / (lexMs * 1000.0),
+			 identifiers.size() / (oldMs * 1000.0), identifiers.size() / (newMs * 1000.0));
+	writeToMinibuffer(message);
+
+	return true;
+}
+
+DEFINE_COMMAND(checkLexerScanning)
+{
+	exitMinibuffer("");
+
+	Point end { BUFFER->data.size() - 1, (unsigned int) BUFFER->data[BUFFER->data.size() - 1].size(), BUFFER };
+	std::string contents = BUFFER->substrFromPoints(Point { 0, 0, BUFFER }, end);
+
+	// NOTE(fkp): Both of these lex a copy so the buffer's own tokens are
+	// left alone, the scalar one is what the vectorised one has to match.
+	Buffer scalar { BufferType::Snapshot, "", "" };
+	scalar.data.loadFromString(std::string(contents));
+	scalar.lexer.lineStates.resize(scalar.data.size());
+	scalar.lexer.isUsingVectorScanning = false;
+
+	Buffer vectorised { BufferType::Snapshot, "", "" };
+	vectorised.data.loadFromString(std::move(contents));
+	vectorised.lexer.lineStates.resize(vectorised.data.size());
+
+	Timer timer;
+	scalar.lexer.lex(0, false, true);
+	double scalarMs = std::max(timer.getElapsedMs(), 0.001);
+
+	timer.reset();
+	vectorised.lexer.lex(0, false, true);
+	double vectorisedMs = std::max(timer.getElapsedMs(), 0.001);
+
+	auto isSamePoint = [](const Point& left, const Point& right)
+					   {
+						   return left.line == right.line && left.col == right.col;
+					   };
+
+	for (unsigned int line = 0; line < scalar.lexer.lineStates.size(); line++)
+	{
+		const LineLexState& expected = scalar.lexer.lineStates[line];
+		const LineLexState& actual = vectorised.lexer.lineStates[line];
+		bool isSame = expected.finishType == actual.finishType && expected.tokens.size() == actual.tokens.size();
+
+		for (std::size_t i = 0; isSame && i < expected.tokens.size(); i++)
+		{
+			const Token& expectedToken = expected.tokens[i];
+			const Token& actualToken = actual.tokens[i];
+
+			isSame = expectedToken.type == actualToken.type && expectedToken.data == actualToken.data &&
+					 isSamePoint(expectedToken.start, actualToken.start) && isSamePoint(expectedToken.end, actualToken.end);
+		}
+
+		if (!isSame)
+		{
+			char message[256];
+			snprintf(message, sizeof(message), "Error: Vectorised lexing differs from scalar lexing on line %u.", line + 1);
+			writeToMinibuffer(message);
+
+			return true;
+		}
+	}
+
+	char message[256];
+	snprintf(message, sizeof(message), "Lexed %u lines the same both ways: scalar %.0fms, vectorised %.0fms (%.1fx)",
+			 scalar.data.size(), scalarMs, vectorisedMs, scalarMs / vectorisedMs);
+	writeToMinibuffer(message);
+
+	return true;
+}
+
+DEFINE_COMMAND(benchmarkUndo)
+{
+	constexpr unsigned int NUMBER_OF_LINES = 100000;
+
+	// NOTE(fkp): This uses its own buffer so nothing real gets changed
+	Buffer buffer { BufferType::Text, "*undo benchmark*", "" };
+	buffer.isUsingSyntaxHighlighting = true;
+
+	std::string paste;
+	for (unsigned int i = 0; i < NUMBER_OF_LINES; i++)
+	{
+		paste += "int value" + std::to_string(i) + " = " + std::to_string(i) + "; // Comment\n";
+	}
+
+	Timer timer;
+	Point point = buffer.insertText(Point { 0, 0, &buffer }, paste);
+	double insertMs = timer.getElapsedMs();
+
+	timer.reset();
+	bool didUndo = buffer.undo(point) && buffer.data.size() == 1;
+	double undoMs = timer.getElapsedMs();
+
+	timer.reset();
+	bool didRedo = buffer.redo(point) && buffer.data.size() == NUMBER_OF_LINES + 1;
+	double redoMs = timer.getElapsedMs();
+
+	if (!didUndo || !didRedo)
+	{
+		exitMinibuffer("Error: Undo benchmark ended up with the wrong text.");
+		return true;
+	}
+
+	// Each of these is a single splice, so should be well under this
+	constexpr double MAX_UNDO_MS = 100.0;
+
+	char message[256];
+	snprintf(message, sizeof(message), "%u line paste (%.1fMB): insert %.1fms, undo %.1fms, redo %.1fms%s",
+			 NUMBER_OF_LINES, paste.size() / (1024.0 * 1024.0), insertMs, undoMs, redoMs,
+			 undoMs > MAX_UNDO_MS || redoMs > MAX_UNDO_MS ? " (too slow!)" : "");
+	exitMinibuffer(message);
+
+	return true;
+}
+
+DEFINE_COMMAND(showBufferStats)
+{
+	exitMinibuffer("");
+
+	const PieceTable& data = BUFFER->data;
+	const LineArena& arena = data.getArena();
+	unsigned int numberOfEdits = data.getNumberOfEdits();
+
+	// Shared lines are only counted once in the stored size
+	std::size_t referencedSize;
+	std::size_t storedSize;
+	data.getOriginalTextSizes(referencedSize, storedSize);
+	double savedKilobytes = referencedSize > storedSize ? (referencedSize - storedSize) / 1024.0 : 0.0;
+
+	char message[320];
+	snprintf(message, sizeof(message), "%u lines, %u edits, %zu allocations (%.4f per edit), text blocks: %.1fKB used, %.1fKB free, %.1fKB reserved, deduplication saved %.1fKB",
+			 data.size(), numberOfEdits, arena.numberOfHeapAllocations,
+			 numberOfEdits > 0 ? (double) arena.numberOfHeapAllocations / (double) numberOfEdits : 0.0,
+			 arena.getNumberOfBytesInUse() / 1024.0, arena.getNumberOfBytesFree() / 1024.0, arena.getNumberOfBytesReserved() / 1024.0,
+			 savedKilobytes);
+	writeToMinibuffer(message);
+
+	return true;
+}
+
+DEFINE_COMMAND(internBufferLines)
+{
+	exitMinibuffer("");
+
+	if (BUFFER->isPaged())
+	{
+		writeToMinibuffer("Error: Paged buffers can't be interned.");
+		return true;
+	}
+
+	BUFFER->isInterningLines = true;
+
+	std::size_t oldReferencedSize;
+	std::size_t oldStoredSize;
+	BUFFER->data.getOriginalTextSizes(oldReferencedSize, oldStoredSize);
+
+	unsigned int numberOfDistinctLines = BUFFER->internLines();
+
+	std::size_t referencedSize;
+	std::size_t storedSize;
+	BUFFER->data.getOriginalTextSizes(referencedSize, storedSize);
+
+	char message[256];
+	snprintf(message, sizeof(message), "%u distinct lines of %u, %.1fKB stored instead of %.1fKB%s",
+			 numberOfDistinctLines, BUFFER->data.size(), storedSize / 1024.0, oldStoredSize / 1024.0,
+			 BUFFER->isLoading() ? " (still loading)" : "");
+	writeToMinibuffer(message);
+
+	return true;
+}
+
 DEFINE_COMMAND(lexBufferAsCpp)
 {
 	exitMinibuffer("");
 	BUFFER->isUsingSyntaxHighlighting = true;
-	BUFFER->lexer.lex(0, true);
+	BUFFER->lexWholeBuffer();
 	
 	return true;
 }
@@ -849,7 +1707,9 @@ DEFINE_COMMAND(compile)
 		window.moveToNextFrame();
 	}
 
+	// The compiler has to see the saved files
 	saveAllBuffers(window, text);
+	Buffer::finishAllSaves();
 
 	Buffer* compileBuffer = Buffer::get("*compilation*");
 	
@@ -0,0 +1,195 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <fstream>
+#include <stdio.h>
+
+#include "file_loader.hpp"
+
+FileLoader::~FileLoader()
+{
+	stop();
+}
+
+bool FileLoader::start(const std::string& filePath, std::string& firstPart)
+{
+	stop();
+
+	path = filePath;
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file)
+	{
+		printf("Error: Failed to read file '%s'.\n", path.c_str());
+		firstPart = "";
+
+		return false;
+	}
+
+	file.seekg(0, std::ios::end);
+	fileSize = (std::uint64_t) file.tellg();
+	file.seekg(0);
+
+	std::size_t sizeToRead = fileSize > FIRST_PART_SIZE ? FIRST_PART_SIZE : (std::size_t) fileSize;
+	firstPart.reserve(sizeToRead + 1);
+	firstPart.resize(sizeToRead);
+	file.read(&firstPart[0], sizeToRead);
+	firstPart.resize((std::size_t) file.gcount());
+
+	if (firstPart.size() == fileSize)
+	{
+		// The whole file fit, this is the same as readFile()
+		if (firstPart.size() > 0 && firstPart.back() != '\n')
+		{
+			firstPart += '\n';
+		}
+
+		numberOfBytesRead = fileSize;
+		return false;
+	}
+
+	// NOTE(fkp): Only whole lines are given out, the rest of the last
+	// line is read again by the thread.
+	std::size_t lastNewline = firstPart.rfind('\n');
+	firstPart.resize(lastNewline == std::string::npos ? 0 : lastNewline + 1);
+
+	loadedText.clear();
+	numberOfBytesRead = firstPart.size();
+	isThreadDone = false;
+	shouldStop = false;
+	loadThread = std::thread(&FileLoader::loadRestOfFile, this, (std::uint64_t) firstPart.size());
+
+	return true;
+}
+
+void FileLoader::stop()
+{
+	shouldStop = true;
+
+	if (loadThread.joinable())
+	{
+		loadThread.join();
+	}
+
+	std::lock_guard<std::mutex> lock { loadedTextMutex };
+	loadedText = std::string();
+}
+
+bool FileLoader::takeLoadedText(std::string& text)
+{
+	std::lock_guard<std::mutex> lock { loadedTextMutex };
+
+	if (loadedText.size() == 0)
+	{
+		return false;
+	}
+
+	text = std::move(loadedText);
+	loadedText.clear();
+
+	return true;
+}
+
+void FileLoader::waitUntilFinished()
+{
+	if (loadThread.joinable())
+	{
+		loadThread.join();
+	}
+}
+
+bool FileLoader::isFinished()
+{
+	if (!isThreadDone)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock { loadedTextMutex };
+	return loadedText.size() == 0;
+}
+
+double FileLoader::getProgress() const
+{
+	if (fileSize == 0)
+	{
+		return 1.0;
+	}
+
+	return (double) numberOfBytesRead / (double) fileSize;
+}
+
+// NOTE(fkp): This runs on its own thread with its own stream
+void FileLoader::loadRestOfFile(std::uint64_t startOffset)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file)
+	{
+		printf("Error: Failed to read file '%s'.\n", path.c_str());
+		isThreadDone = true;
+
+		return;
+	}
+
+	file.seekg((std::streamoff) startOffset);
+
+	// Holds the start of a line that carries on into the next chunk
+	std::string chunk;
+
+	while (!shouldStop)
+	{
+		std::size_t carrySize = chunk.size();
+		chunk.resize(carrySize + CHUNK_SIZE);
+		file.read(&chunk[carrySize], CHUNK_SIZE);
+		std::size_t numberRead = (std::size_t) file.gcount();
+		chunk.resize(carrySize + numberRead);
+
+		bool isAtEnd = numberRead < CHUNK_SIZE;
+		std::string lines;
+
+		if (isAtEnd)
+		{
+			// Every line (including the last) ends with a newline
+			if (chunk.size() > 0 && chunk.back() != '\n')
+			{
+				chunk += '\n';
+			}
+
+			lines = std::move(chunk);
+			chunk.clear();
+		}
+		else
+		{
+			std::size_t lastNewline = chunk.rfind('\n');
+
+			if (lastNewline != std::string::npos)
+			{
+				lines.assign(chunk, 0, lastNewline + 1);
+				chunk.erase(0, lastNewline + 1);
+			}
+		}
+
+		if (lines.size() > 0)
+		{
+			std::lock_guard<std::mutex> lock { loadedTextMutex };
+
+			if (loadedText.size() == 0)
+			{
+				loadedText = std::move(lines);
+			}
+			else
+			{
+				loadedText += lines;
+			}
+		}
+
+		numberOfBytesRead += numberRead;
+
+		if (isAtEnd)
+		{
+			break;
+		}
+	}
+
+	isThreadDone = true;
+}
@@ -0,0 +1,110 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <stdio.h>
+#include <utility>
+
+#include "file_mapping.hpp"
+
+FileMapping::~FileMapping()
+{
+	close();
+}
+
+FileMapping::FileMapping(FileMapping&& other)
+{
+	*this = std::move(other);
+}
+
+FileMapping& FileMapping::operator=(FileMapping&& other)
+{
+	if (this != &other)
+	{
+		close();
+
+		std::swap(fileHandle, other.fileHandle);
+		std::swap(mappingHandle, other.mappingHandle);
+		std::swap(mappedData, other.mappedData);
+		std::swap(mappedSize, other.mappedSize);
+	}
+
+	return *this;
+}
+
+bool FileMapping::open(const std::string& path)
+{
+	close();
+
+	HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		printf("Error: Failed to open file '%s' for mapping (%lu).\n", path.c_str(), (unsigned long) GetLastError());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		printf("Error: Failed to get the size of file '%s'.\n", path.c_str());
+		CloseHandle(file);
+
+		return false;
+	}
+
+	fileHandle = file;
+	mappedSize = (std::size_t) fileSize.QuadPart;
+
+	// NOTE(fkp): Empty files can't be mapped, but they are still valid
+	if (mappedSize == 0)
+	{
+		return true;
+	}
+
+	mappingHandle = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!mappingHandle)
+	{
+		printf("Error: Failed to create a mapping of file '%s' (%lu).\n", path.c_str(), (unsigned long) GetLastError());
+		close();
+
+		return false;
+	}
+
+	mappedData = (const char*) MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+	if (!mappedData)
+	{
+		printf("Error: Failed to map a view of file '%s' (%lu).\n", path.c_str(), (unsigned long) GetLastError());
+		close();
+
+		return false;
+	}
+
+	return true;
+}
+
+void FileMapping::close()
+{
+	if (mappedData)
+	{
+		UnmapViewOfFile(mappedData);
+		mappedData = nullptr;
+	}
+
+	if (mappingHandle)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+
+	if (fileHandle)
+	{
+		CloseHandle(fileHandle);
+		fileHandle = nullptr;
+	}
+
+	mappedSize = 0;
+}
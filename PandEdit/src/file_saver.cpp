@@ -0,0 +1,96 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <stdio.h>
+
+#include "file_saver.hpp"
+#include "timer.hpp"
+
+FileSaver::~FileSaver()
+{
+	waitUntilFinished();
+}
+
+void FileSaver::start(const std::string& filePath, std::string&& fileContents)
+{
+	waitUntilFinished();
+
+	path = filePath;
+	contents = std::move(fileContents);
+	size = contents.size();
+	wasSuccessful = false;
+	elapsedMs = 0.0;
+	isThreadDone = false;
+	saveThread = std::thread(&FileSaver::save, this);
+}
+
+void FileSaver::waitUntilFinished()
+{
+	if (saveThread.joinable())
+	{
+		saveThread.join();
+	}
+}
+
+bool FileSaver::isFinished() const
+{
+	return isThreadDone;
+}
+
+// NOTE(fkp): This runs on its own thread
+void FileSaver::save()
+{
+	Timer timer;
+	std::string tempPath = path + TEMP_FILE_EXTENSION;
+	bool success = false;
+
+	HANDLE file = CreateFile(tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		printf("Error: Failed to open file '%s' for saving to (%lu).\n", tempPath.c_str(), (unsigned long) GetLastError());
+	}
+	else
+	{
+		std::size_t numberWritten = 0;
+
+		while (numberWritten < contents.size())
+		{
+			std::size_t sizeToWrite = contents.size() - numberWritten;
+			if (sizeToWrite > WRITE_SIZE) sizeToWrite = WRITE_SIZE;
+
+			DWORD numberWrittenNow = 0;
+
+			if (!WriteFile(file, contents.data() + numberWritten, (DWORD) sizeToWrite, &numberWrittenNow, nullptr) ||
+				numberWrittenNow == 0)
+			{
+				printf("Error: Failed to write to file '%s' (%lu).\n", tempPath.c_str(), (unsigned long) GetLastError());
+				break;
+			}
+
+			numberWritten += numberWrittenNow;
+		}
+
+		// The contents have to be on disk before the rename, otherwise a
+		// crash could still leave an empty file.
+		success = numberWritten == contents.size() && FlushFileBuffers(file);
+		CloseHandle(file);
+
+		if (success && !MoveFileEx(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		{
+			printf("Error: Failed to replace file '%s' (%lu).\n", path.c_str(), (unsigned long) GetLastError());
+			success = false;
+		}
+
+		if (!success)
+		{
+			DeleteFile(tempPath.c_str());
+		}
+	}
+
+	contents = std::string();
+	elapsedMs = timer.getElapsedMs();
+	wasSuccessful = success;
+	isThreadDone = true;
+}
@@ -14,7 +14,7 @@ std::string readFile(const char* filename, bool createIfNotExists)
 		std::ofstream file(filename, std::ios::app);
 	}
 	
-	std::ifstream file(filename);
+	std::ifstream file(filename, std::ios::binary);
 
 	if (!file)
 	{
@@ -22,21 +22,23 @@ std::string readFile(const char* filename, bool createIfNotExists)
 		return "";
 	}
 
-	/* NOTE(fkp): This doesn't work because of Windows' \r\n line endings
+	// NOTE(fkp): This is read in one go, '\r\n' line endings are left
+	// for whoever splits the lines (see PieceTable::loadFromString()).
 	file.seekg(0, std::ios::end);
-	std::size_t size = file.tellg();
+	std::size_t size = (std::size_t) file.tellg();
 	file.seekg(0);
 
-	std::string buffer(size, ' ');
-	file.read(&buffer[0], size);
-	*/
-
+	// One extra for the final newline
 	std::string buffer;
-	std::string line;
+	buffer.reserve(size + 1);
+	buffer.resize(size);
+	file.read(&buffer[0], size);
+	buffer.resize((std::size_t) file.gcount());
 
-	while (std::getline(file, line))
+	// Every line (including the last) ends with a newline
+	if (buffer.size() > 0 && buffer.back() != '\n')
 	{
-		buffer += line + '\n';
+		buffer += '\n';
 	}
 
 	return buffer;
@@ -10,6 +10,9 @@
 #include "font.hpp"
 #include "undo.hpp"
 #include "commands.hpp"
+#include "common.hpp"
+#include "rectangle.hpp"
+#include "region_transforms.hpp"
 
 Frame::Frame(std::string name, Vector4f dimensions, unsigned int windowWidth, unsigned int windowHeight, Buffer* buffer, bool isActive)
 {
@@ -55,10 +58,13 @@ void Frame::switchToBuffer(Buffer* buffer)
 		currentBuffer->lastPoint = point;
 		currentBuffer->lastPoint.targetCol = point.col; // Don't want to save the target col
 		currentBuffer->lastTopLine = targetTopLine;
+		removeAnchors();
+		cursors.clear();
 	}
 
 	currentBuffer = buffer;
 	point = currentBuffer->lastPoint;
+	addAnchors();
 	targetTopLine = currentBuffer->lastTopLine;
 	currentTopLine = targetTopLine;
 	popupLines.clear();
@@ -84,6 +90,11 @@ Frame::~Frame()
 {
 	framesMap.erase(name);
 
+	if (currentBuffer)
+	{
+		removeAnchors();
+	}
+
 	if (this == minibufferFrame)
 	{
 		minibufferFrame = nullptr;
@@ -100,6 +111,12 @@ Frame::Frame(Frame&& other)
 {
 	framesMap[name] = this;
 	other.name = "";
+
+	if (currentBuffer)
+	{
+		other.removeAnchors();
+		addAnchors();
+	}
 	
 	other.parent = nullptr;
 	other.childOne = nullptr;
@@ -128,6 +145,11 @@ Frame& Frame::operator=(Frame&& other)
 	{
 		framesMap.erase(name);
 
+		if (currentBuffer)
+		{
+			removeAnchors();
+		}
+
 		name = other.name;
 
 		parent = other.parent;
@@ -145,6 +167,12 @@ Frame& Frame::operator=(Frame&& other)
 		point = other.point;
 		targetTopLine = other.targetTopLine;
 		currentTopLine = other.currentTopLine;
+
+		if (currentBuffer)
+		{
+			other.removeAnchors();
+			addAnchors();
+		}
 		
 		if (&other == Frame::currentFrame)
 		{
@@ -246,6 +274,8 @@ void Frame::split(bool vertically, Font* currentFont)
 	}
 	
 	// Invalidates everything for this frame
+	removeAnchors();
+	cursors.clear();
 	currentBuffer = nullptr;
 	point = Point {};
 	mark = Point {};
@@ -278,6 +308,29 @@ void Frame::destroy()
 	parent->deleteChildFrames(sibling);
 }
 
+void Frame::addAnchors()
+{
+	currentBuffer->anchors.add(&point, AnchorGravity::Right);
+	currentBuffer->anchors.add(&mark, AnchorGravity::Left);
+
+	for (std::unique_ptr<Point>& cursor : cursors)
+	{
+		currentBuffer->anchors.add(cursor.get(), AnchorGravity::Right);
+	}
+}
+
+void Frame::removeAnchors()
+{
+	std::vector<Point*> anchors = { &point, &mark };
+
+	for (std::unique_ptr<Point>& cursor : cursors)
+	{
+		anchors.push_back(cursor.get());
+	}
+
+	currentBuffer->anchors.remove(std::move(anchors));
+}
+
 void Frame::deleteChildFrames(Frame* otherChild)
 {
 	if (!childOne || !childTwo)
@@ -323,6 +376,7 @@ void Frame::deleteChildFrames(Frame* otherChild)
 		currentBuffer = otherChild->currentBuffer;
 		point = otherChild->point;
 		mark = otherChild->mark;
+		addAnchors();
 		targetTopLine = otherChild->targetTopLine;
 		currentTopLine = otherChild->currentTopLine;
 
@@ -424,74 +478,32 @@ std::pair<Point, Point> Frame::getPointStartAndEnd()
 
 std::string Frame::getTextPointToMark()
 {
-	std::string result;
-
 	auto startAndEnd = getPointStartAndEnd();
-	Point start = startAndEnd.first;
-	Point end = startAndEnd.second;
-	
-	for (int currentLine = start.line; currentLine <= end.line; currentLine++)
-	{
-		if (currentLine == start.line)
-		{
-			// Checks if the mark is on the same line as the point
-			if (start.line == end.line)
-			{
-				result = currentBuffer->data[currentLine].substr(start.col, end.col - start.col);
-			}
-			else
-			{
-				result += currentBuffer->data[currentLine].substr(start.col, std::string::npos);
-				result += '\n';
-			}
-		}
-		else if (currentLine == end.line)
-		{
-			// NOTE(fkp): We don't need to check if point.line == mark.line
-			// here because this is in an else if from the previous
-			// if.
-			result += currentBuffer->data[currentLine].substr(0, end.col);
-		}
-		else
-		{
-			result += currentBuffer->data[currentLine];
-			result += '\n';
-		}
-	}
-
-	return result;
+	return currentBuffer->substrFromPoints(startAndEnd.first, startAndEnd.second);
 }
 
 void Frame::deleteTextPointToMark(bool appendToKillRing)
 {
 	if (!warnIfBufferIsReadOnly()) return;
 	
-	std::string text = getTextPointToMark();
-	
-	if (appendToKillRing)
-	{
-		// TODO(fkp): Pass in text to avoid getting it twice
-		copyRegion();
-	}
-	
 	auto startAndEnd = getPointStartAndEnd();
 	Point start = startAndEnd.first;
 	Point end = startAndEnd.second;
 	point = end;
 
-	bool oldShouldAddInformation = currentBuffer->shouldAddToUndoInformation;
-	currentBuffer->shouldAddToUndoInformation = false;
+	std::string text = currentBuffer->eraseRange(start, end);
 	
-	while (point > start)
+	if (appendToKillRing && text != "")
 	{
-		backspaceChar();
+		copyRegion(text);
 	}
 
 	point = start;
+	point.targetCol = point.col;
 	mark = start;
-	
-	currentBuffer->shouldAddToUndoInformation = oldShouldAddInformation;
-	currentBuffer->addActionToUndoBuffer(Action::deletion(start, end, text));
+
+	doCommonPointManipulationTasks();
+	updatePopups();
 }
 
 void Frame::deleteRestOfLine()
@@ -511,11 +523,18 @@ void Frame::deleteRestOfLine()
 
 void Frame::doCommonPointManipulationTasks()
 {
+	if (transactionDepth > 0)
+	{
+		hasPendingPointTasks = true;
+		return;
+	}
+
 	pointFlashTimer.reset();
+	currentBuffer->ensurePagedLinesLoaded((int) point.line - (int) numberOfLinesInView, numberOfLinesInView * 2);
 
 	if (currentBuffer->type != BufferType::MiniBuffer)
 	{
-		Frame::minibufferFrame->currentBuffer->data[0] = "";
+		Frame::minibufferFrame->currentBuffer->data.setLine(0, "");
 		Frame::minibufferFrame->point.col = 0;
 	}
 
@@ -573,41 +592,82 @@ void Frame::doCommonPointManipulationTasks()
 	// popupCurrentSuggestion = 0;
 }
 
-void Frame::doCommonBufferManipulationTasks()
+void Frame::beginTransaction()
 {
-	if (!warnIfBufferIsReadOnly()) return;
-	
-	// TODO(fkp): Figure out which lex mode to use
-	if (currentBuffer->isUsingSyntaxHighlighting && shouldReLexBuffer)
+	if (transactionDepth == 0)
 	{
-		currentBuffer->lexer.lex(point.line, false);
+		transactionBuffer = currentBuffer;
+		transactionBuffer->beginTransaction();
+	}
+
+	transactionDepth += 1;
+}
+
+void Frame::commitTransaction()
+{
+	if (transactionDepth == 0)
+	{
+		ERROR_ONCE("Error: Committing a transaction that was never started.\n");
+		return;
+	}
+
+	transactionDepth -= 1;
+	if (transactionDepth > 0) return;
+
+	transactionBuffer->commitTransaction();
+	transactionBuffer = nullptr;
+
+	if (hasPendingPointTasks)
+	{
+		hasPendingPointTasks = false;
+		doCommonPointManipulationTasks();
+	}
+
+	if (hasPendingPopupUpdate)
+	{
+		hasPendingPopupUpdate = false;
+		updatePopups();
 	}
 }
 
 void Frame::insertChar(char character)
 {
 	if (!warnIfBufferIsReadOnly()) return;
-	
-	Point startLocation = point;
+
+	if (cursors.size() > 0)
+	{
+		insertAtCursors(std::string_view { &character, 1 });
+		return;
+	}
+
+	// The matching pair is part of the same edit
+	beginTransaction();
 
 	if (overwriteMode && point.col < currentBuffer->data[point.line].size())
 	{
-		currentBuffer->data[point.line][point.col] = character;
+		// NOTE(fkp): This is recorded as the old character being deleted
+		// and the new one inserted, so both undo and the journal put the
+		// old one back.
+		Point startLocation = point;
+		char oldCharacter = currentBuffer->data[point.line][point.col];
+		currentBuffer->data.overwriteChar(point.line, point.col, character);
+		point.col += 1;
+
+		currentBuffer->addActionToUndoBuffer(ActionType::Deletion, startLocation, point, std::string_view { &oldCharacter, 1 });
+		currentBuffer->addActionToUndoBuffer(ActionType::Insertion, startLocation, point, std::string_view { &character, 1 });
+		currentBuffer->lexLines(point.line, point.line);
 	}
 	else
 	{
-		currentBuffer->data[point.line].insert(currentBuffer->data[point.line].begin() + point.col, character);
+		Point end = currentBuffer->insertText(point, std::string_view { &character, 1 });
+		point.line = end.line;
+		point.col = end.col;
 	}
 	
-	point.col += 1;
 	point.targetCol = point.col;
 
-	currentBuffer->addActionToUndoBuffer(Action::insertion(startLocation, point, std::string(1, character)));
-
-	adjustOtherFramePointLocations(true, false);
 	doCommonPointManipulationTasks();
-	doCommonBufferManipulationTasks();
-	if (shouldUpdatePopups) updatePopups();
+	updatePopups();
 
 	// Matching pairs
 	// TODO(fkp): Check to see if there is already a matching character
@@ -626,148 +686,96 @@ void Frame::insertChar(char character)
 		insertChar(']');
 		movePointLeft();
 	}
+
+	commitTransaction();
 }
 
 void Frame::backspaceChar(unsigned int num, bool copyText)
 {
 	if (!warnIfBufferIsReadOnly()) return;
 	
-	std::string textDeleted = "";
-	Point endLocation = point; // This is not startLocation because we are going backwards
-
 	if (num == 0) num = 1;
 
-	for (int i = 0; i < num; i++)
+	if (cursors.size() > 0)
 	{
-		if (point.col > 0)
-		{
-			if (currentBuffer->type == BufferType::MiniBuffer &&
-				point.col <= Frame::minibufferFrame->currentBuffer->data[0].find_first_of(' ') + 1)
-			{
-				// Should not be able to backspace into the 'Execute: ' part
-				break;
-			}
-
-			point.col -= 1;
-			textDeleted.insert(0, currentBuffer->data[point.line].substr(point.col, 1));
-			currentBuffer->data[point.line].erase(point.col, 1);
-
-			adjustOtherFramePointLocations(false, false);
-		}
-		else
-		{
-			if (point.line > 0)
-			{
-				point.line -= 1;
-				point.col = currentBuffer->data[point.line].size();
+		eraseAtCursors(num, 0);
+		return;
+	}
 
-				textDeleted.insert(0, "\n");
-				currentBuffer->data[point.line] += currentBuffer->data[point.line + 1];
-				currentBuffer->data.erase(currentBuffer->data.begin() + point.line + 1);
+	Point end { point.line, point.col, currentBuffer }; // This is not start because we are going backwards
+	Point start = end - num;
 
-				if (currentBuffer->isUsingSyntaxHighlighting)
-				{
-					currentBuffer->lexer.removeLine(point);
-				}
-				
-				adjustOtherFramePointLocations(false, true);
-			}
-		}
+	if (currentBuffer->type == BufferType::MiniBuffer)
+	{
+		// Should not be able to backspace into the 'Execute: ' part
+		unsigned int promptEnd = (unsigned int) (currentBuffer->data[0].find_first_of(' ') + 1);
+		start.col = std::max(start.col, std::min(end.col, promptEnd));
 	}
 
+	std::string textDeleted = currentBuffer->eraseRange(start, end);
+	point.line = start.line;
+	point.col = start.col;
+
 	if (copyText)
 	{
 		copyRegion(textDeleted);
 	}
 
-	currentBuffer->addActionToUndoBuffer(Action::deletion(point, endLocation, std::move(textDeleted)));	
 	point.targetCol = point.col;
 	
 	doCommonPointManipulationTasks();
-	doCommonBufferManipulationTasks();
-	if (shouldUpdatePopups) updatePopups();
+	updatePopups();
 }
 
 void Frame::deleteChar(unsigned int num, bool copyText)
 {
 	if (!warnIfBufferIsReadOnly()) return;
 	
-	std::string textDeleted = "";
-
 	if (num == 0) num = 1;
 
-	for (int i = 0; i < num; i++)
+	if (cursors.size() > 0)
 	{
-		if (point.col < currentBuffer->data[point.line].size())
-		{
-			textDeleted += currentBuffer->data[point.line].substr(point.col, 1);
-			currentBuffer->data[point.line].erase(point.col, 1);
-			adjustOtherFramePointLocations(false, false);
-		}
-		else
-		{
-			if (point.line < currentBuffer->data.size() - 1)
-			{
-				textDeleted += '\n';
-				
-				currentBuffer->data[point.line] += currentBuffer->data[point.line + 1];
-				currentBuffer->data.erase(currentBuffer->data.begin() + point.line + 1);
-
-				if (currentBuffer->isUsingSyntaxHighlighting)
-				{
-					currentBuffer->lexer.removeLine(point);
-				}
-
-				adjustOtherFramePointLocations(false, true);
-			}
-		}
+		eraseAtCursors(0, num);
+		return;
 	}
 
+	Point start { point.line, point.col, currentBuffer };
+	Point end = start + num;
+	std::string textDeleted = currentBuffer->eraseRange(start, end);
+
 	if (copyText)
 	{
 		copyRegion(textDeleted);
 	}
 
-	currentBuffer->addActionToUndoBuffer(Action::deletion(point, point, std::move(textDeleted)));
 	point.targetCol = point.col;
 	
 	doCommonPointManipulationTasks();
-	doCommonBufferManipulationTasks();
 }
 
 void Frame::newLine()
 {
 	if (!warnIfBufferIsReadOnly()) return;
 
+	if (cursors.size() > 0)
+	{
+		insertAtCursors("\n");
+		return;
+	}
+
 	// This is for proper expansion of braces
 	bool isExpandingBraces = point.col > 0 &&
 							 currentBuffer->data[point.line][point.col] == '}' &&
 							 currentBuffer->data[point.line][point.col - 1] == '{';
 	
-	Point startLocation = point;
-
-	std::string restOfLine { currentBuffer->data[point.line].begin() + point.col, currentBuffer->data[point.line].end() };
-	currentBuffer->data[point.line].erase(currentBuffer->data[point.line].begin() + point.col, currentBuffer->data[point.line].end());
+	beginTransaction();
 
-	point.line += 1;
-	point.col = 0;
+	Point end = currentBuffer->insertText(point, "\n");
+	point.line = end.line;
+	point.col = end.col;
 	point.targetCol = point.col;
 
-	currentBuffer->data.insert(currentBuffer->data.begin() + point.line, restOfLine);
-	currentBuffer->addActionToUndoBuffer(Action::insertion(startLocation, point, std::string(1, '\n')));
-
-	if (currentBuffer->isUsingSyntaxHighlighting)
-	{
-		currentBuffer->lexer.addLine(startLocation);
-	}
-
-	// TODO(fkp): This is a hack
-	point.line -= 1;
-	doCommonBufferManipulationTasks();
-	point.line += 1;
-	
 	doCommonPointManipulationTasks();
-	adjustOtherFramePointLocations(true, true);
 
 	if (isExpandingBraces)
 	{
@@ -775,42 +783,149 @@ void Frame::newLine()
 		newLine();
 		movePointLeft();
 	}
+
+	commitTransaction();
 }
 
 void Frame::insertString(const std::string& string)
 {
 	if (!warnIfBufferIsReadOnly()) return;
+
+	if (cursors.size() > 0)
+	{
+		insertAtCursors(string);
+		return;
+	}
 	
-	Point startLocation = point;
-	bool oldShouldAddInformation = currentBuffer->shouldAddToUndoInformation;
 	unsigned int oldTopLine = targetTopLine;
-	currentBuffer->shouldAddToUndoInformation = false;
 
-	for (char character : string)
+	Point end = currentBuffer->insertText(point, string);
+	point.line = end.line;
+	point.col = end.col;
+	point.targetCol = point.col;
+
+	doCommonPointManipulationTasks();
+
+	if (targetTopLine != oldTopLine)
+	{
+		centerPoint();
+	}
+
+	updatePopups();
+}
+
+void Frame::addCursor(const Point& location)
+{
+	cursors.push_back(std::make_unique<Point>(location.line, location.col, currentBuffer));
+	currentBuffer->anchors.add(cursors.back().get(), AnchorGravity::Right);
+}
+
+void Frame::clearCursors()
+{
+	std::vector<Point*> anchors;
+
+	for (std::unique_ptr<Point>& cursor : cursors)
 	{
-		if (character == '\n')
+		anchors.push_back(cursor.get());
+	}
+
+	currentBuffer->anchors.remove(std::move(anchors));
+	cursors.clear();
+}
+
+// NOTE(fkp): Cursors end up in the same place after deleting
+// between them, or when one is added twice.
+void Frame::removeDuplicateCursors()
+{
+	std::sort(cursors.begin(), cursors.end(), [](const std::unique_ptr<Point>& first, const std::unique_ptr<Point>& second)
+			  {
+				  return *first < *second;
+			  });
+
+	std::vector<Point*> duplicates;
+	std::vector<std::unique_ptr<Point>> uniqueCursors;
+
+	for (std::unique_ptr<Point>& cursor : cursors)
+	{
+		bool isAtPoint = !(*cursor < point) && !(point < *cursor);
+		bool isAtLastCursor = uniqueCursors.size() > 0 && !(*uniqueCursors.back() < *cursor);
+
+		if (isAtPoint || isAtLastCursor)
 		{
-			newLine();
+			duplicates.push_back(cursor.get());
 		}
-		else if (character != '\r') // Windows has CRLF endings
+		else
 		{
-			bool oldShouldReLexBuffer = shouldReLexBuffer;
-			shouldReLexBuffer = false;
-			
-			insertChar(character);
-			
-			shouldReLexBuffer = oldShouldReLexBuffer;
+			uniqueCursors.push_back(std::move(cursor));
 		}
 	}
 
-	if (targetTopLine != oldTopLine)
+	if (duplicates.size() > 0)
 	{
-		centerPoint();
+		currentBuffer->anchors.remove(std::move(duplicates));
+	}
+
+	cursors = std::move(uniqueCursors);
+}
+
+std::vector<Point> Frame::getCursorLocations()
+{
+	removeDuplicateCursors();
+
+	std::vector<Point> locations;
+	locations.reserve(cursors.size() + 1);
+	locations.emplace_back(point.line, point.col, currentBuffer);
+
+	for (std::unique_ptr<Point>& cursor : cursors)
+	{
+		locations.emplace_back(cursor->line, cursor->col, currentBuffer);
+	}
+
+	std::sort(locations.begin(), locations.end());
+	return locations;
+}
+
+void Frame::insertAtCursors(std::string_view text)
+{
+	std::vector<Point> locations = getCursorLocations();
+
+	beginTransaction();
+	currentBuffer->insertTextAtPoints(locations, text);
+
+	point.targetCol = point.col;
+	doCommonPointManipulationTasks();
+	commitTransaction();
+}
+
+void Frame::eraseAtCursors(unsigned int numberBefore, unsigned int numberAfter)
+{
+	std::vector<Point> locations = getCursorLocations();
+	std::vector<std::pair<Point, Point>> ranges;
+	ranges.reserve(locations.size());
+
+	for (Point& location : locations)
+	{
+		Point start = location - numberBefore;
+		Point end = location + numberAfter;
+
+		// Ranges that run into each other are erased together
+		if (ranges.size() > 0 && start < ranges.back().second)
+		{
+			ranges.back().second = std::max(ranges.back().second, end);
+		}
+		else
+		{
+			ranges.emplace_back(start, end);
+		}
 	}
 
-	doCommonBufferManipulationTasks();
-	currentBuffer->shouldAddToUndoInformation = oldShouldAddInformation;
-	currentBuffer->addActionToUndoBuffer(Action::insertion(startLocation, point, string));
+	beginTransaction();
+	currentBuffer->eraseRanges(ranges);
+	removeDuplicateCursors();
+
+	point.targetCol = point.col;
+	doCommonPointManipulationTasks();
+	commitTransaction();
 }
 
 void Frame::movePointLeft(unsigned int num)
@@ -931,6 +1046,7 @@ void Frame::movePointEnd()
 
 void Frame::movePointToBufferStart()
 {
+	currentBuffer->pageToStart();
 	point.line = 0;
 	point.col = 0;
 	point.targetCol = 0;
@@ -940,6 +1056,8 @@ void Frame::movePointToBufferStart()
 
 void Frame::movePointToBufferEnd()
 {
+	currentBuffer->finishLoading();
+	currentBuffer->pageToEnd();
 	point.line = currentBuffer->data.size() - 1;
 	point.col = currentBuffer->data[point.line].size();
 	point.targetCol = point.col;
@@ -949,6 +1067,10 @@ void Frame::movePointToBufferEnd()
 
 void Frame::moveView(int numberOfLines, bool movePoint)
 {
+	// NOTE(fkp): This may move the window of a paged buffer (and so
+	// targetTopLine), but the number of lines to move stays the same.
+	currentBuffer->ensurePagedLinesLoaded(targetTopLine + numberOfLines, numberOfLinesInView);
+	
 	unsigned int oldLineTop = targetTopLine;
 	int newLineTop = (int) targetTopLine + numberOfLines;
 
@@ -1141,8 +1263,9 @@ void Frame::getRect(Font* currentFont, int* realPixelX, unsigned int* realPixelW
 	if (pixelHeight) *pixelHeight = tempPixelHeight;
 }
 
-void Frame::getPointRect(Font* currentFont, unsigned int tabWidth, int framePixelX, int framePixelY, float* pointX, float* pointY, float* pointWidth, float* pointHeight)
+void Frame::getPointRect(Font* currentFont, unsigned int tabWidth, int framePixelX, int framePixelY, float* pointX, float* pointY, float* pointWidth, float* pointHeight, const Point* location)
 {
+	const Point& point = location ? *location : this->point;
 	float tempPointX = framePixelX;
 	float tempPointY = framePixelY + ((point.line - currentTopLine) * currentFont->size);
 	float tempPointWidth;
@@ -1247,89 +1370,6 @@ void Frame::moveColToTarget()
 	}
 }
 
-// TODO(fkp): Cleanup. This method is one big mess and probably
-// riddled with bugs.
-void Frame::adjustOtherFramePointLocations(bool insertion, bool lineWrap)
-{
-	if (!warnIfBufferIsReadOnly()) return;
-	
-	for (Frame* frame : *allFrames)
-	{
-		if (frame == this) continue;
-
-		if (currentBuffer == frame->currentBuffer)
-		{
-			if (insertion)
-			{
-				if (point.line == frame->point.line)
-				{
-					if (lineWrap)
-					{
-						frame->point.line += 1;
-					}
-					else
-					{
-						if (point.col <= frame->point.col + 1)
-						{
-							frame->point.col += 1;
-						}
-					}
-				}
-				else if (point.line == frame->point.line + 1)
-				{
-					if (lineWrap)
-					{
-						if (frame->point.col >= frame->currentBuffer->data[frame->point.line].size())
-						{
-							frame->point.col -= frame->currentBuffer->data[frame->point.line].size();
-							frame->point.line += 1;
-						}
-					}
-				}
-				else if (point.line < frame->point.line)
-				{
-					if (lineWrap)
-					{
-						frame->point.line += 1;
-					}
-				}
-			}
-			else
-			{
-				if (point.line == frame->point.line)
-				{
-					if (lineWrap)
-					{
-						frame->point.col += point.col;
-					}
-					else
-					{
-						if (point.col < frame->point.col)
-						{
-							frame->point.col -= 1;
-						}
-					}
-				}
-				else if (point.line == frame->point.line - 1)
-				{
-					if (lineWrap)
-					{
-						frame->point.line -= 1;
-						frame->point.col += point.col;
-					}
-				}
-				else if (point.line < frame->point.line - 1)
-				{
-					if (lineWrap)
-					{
-						frame->point.line -= 1;
-					}
-				}
-			}
-		}
-	}
-}
-
 bool Frame::warnIfBufferIsReadOnly()
 {
 	if (currentBuffer->isReadOnly)
@@ -1337,6 +1377,12 @@ bool Frame::warnIfBufferIsReadOnly()
 		writeToMinibuffer("Cannot modify buffer - read only.");
 		return false;
 	}
+	else if (currentBuffer->isLoading() && point.line + 2 >= currentBuffer->data.size())
+	{
+		// The rest of the file is added at the end
+		writeToMinibuffer("Cannot modify the end of the buffer while it is loading.");
+		return false;
+	}
 
 	return true;
 }
@@ -1344,6 +1390,12 @@ bool Frame::warnIfBufferIsReadOnly()
 // TODO(fkp): This method has a lot of code duplication, clean it up.
 void Frame::updatePopups()
 {
+	if (transactionDepth > 0)
+	{
+		hasPendingPopupUpdate = true;
+		return;
+	}
+
 	if (!warnIfBufferIsReadOnly()) return;
 	
 	std::vector<std::pair<std::string::size_type, std::pair<std::string, std::string>>> foundMatches;
@@ -1355,7 +1407,7 @@ void Frame::updatePopups()
 			// The path up to the last directory
 			std::string::size_type startOfPathIndex = currentBuffer->data[0].find_first_of(' ') + 1;
 			std::string::size_type lastSlashIndex = currentBuffer->data[0].find_last_of("/\\");
-			std::string currentValidPath = currentBuffer->data[0].substr(startOfPathIndex, lastSlashIndex - startOfPathIndex + 1);
+			std::string currentValidPath { currentBuffer->data[0].substr(startOfPathIndex, lastSlashIndex - startOfPathIndex + 1) };
 
 			if (lastSlashIndex == std::string::npos)
 			{
@@ -1363,7 +1415,7 @@ void Frame::updatePopups()
 				currentValidPath = "";
 			}
 			
-			std::string currentNextItem = currentBuffer->data[0].substr(lastSlashIndex + 1);
+			std::string currentNextItem { currentBuffer->data[0].substr(lastSlashIndex + 1) };
 
 			if (std::filesystem::exists(currentValidPath))
 			{
@@ -1389,7 +1441,7 @@ void Frame::updatePopups()
 		}
 		else if (Commands::currentlyReading == MinibufferReading::BufferName)
 		{
-			std::string bufferName = currentBuffer->data[0].substr(currentBuffer->data[0].find_first_of(' ') + 1);
+			std::string bufferName { currentBuffer->data[0].substr(currentBuffer->data[0].find_first_of(' ') + 1) };
 
 			for (const std::pair<const std::string, Buffer*>& buffer : Buffer::buffersMap)
 			{
@@ -1409,7 +1461,7 @@ void Frame::updatePopups()
 		}
 		else if (Commands::currentlyReading == MinibufferReading::Command)
 		{
-			std::string commandText = currentBuffer->data[0].substr(currentBuffer->data[0].find_first_of(' ') + 1);
+			std::string commandText { currentBuffer->data[0].substr(currentBuffer->data[0].find_first_of(' ') + 1) };
 
 			if (commandText == "")
 			{
@@ -1469,28 +1521,28 @@ void Frame::updatePopups()
 			}
 
 			// TODO(fkp): Should we really be iterating these every time?
-			for (const std::string& keyword : Lexer::keywords)
+			for (std::string_view keyword : KEYWORDS)
 			{
 				if (tokenText != keyword)
 				{
-					std::string::size_type index = keyword.find(tokenText);
+					std::string_view::size_type index = keyword.find(tokenText);
 			
-					if (index != std::string::npos)
+					if (index != std::string_view::npos)
 					{
-						foundMatches.emplace_back(index, std::make_pair(keyword, ""));
+						foundMatches.emplace_back(index, std::make_pair(std::string(keyword), ""));
 					}
 				}
 			}
 		
-			for (const std::string& type : Lexer::primitiveTypes)
+			for (std::string_view type : PRIMITIVE_TYPES)
 			{
 				if (tokenText != type)
 				{
-					std::string::size_type index = type.find(tokenText);
+					std::string_view::size_type index = type.find(tokenText);
 			
-					if (index != std::string::npos)
+					if (index != std::string_view::npos)
 					{
-						foundMatches.emplace_back(index, std::make_pair(type, ""));
+						foundMatches.emplace_back(index, std::make_pair(std::string(type), ""));
 					}
 				}
 			}
@@ -1515,8 +1567,6 @@ void Frame::completeSuggestion()
 	
 	if (popupLines.size() > 0)
 	{
-		bool oldShouldUpdatePopups = shouldUpdatePopups;
-		shouldUpdatePopups = false;
 		std::string suggestion = popupLines[popupCurrentSuggestion].first;
 		
 		Token* tokenUnderPoint = getTokenUnderPoint(true);
@@ -1547,19 +1597,24 @@ void Frame::completeSuggestion()
 		
 		if (tokenUnderPoint)
 		{
+			// NOTE(fkp): The token is gone once it is backspaced over
+			Point tokenStart = tokenUnderPoint->start;
 			point = tokenUnderPoint->end;
 
-			while (point > tokenUnderPoint->start)
+			beginTransaction();
+
+			if (point > tokenStart)
 			{
-				backspaceChar();
+				backspaceChar((unsigned int) currentBuffer->distance(tokenStart, point));
 			}
 
 			insertString(suggestion);
+			commitTransaction();
 		}
 
+		// NOTE(fkp): This has to be after the commit, which updates them
 		popupLines.clear();
 		popupCurrentSuggestion = 0;
-		shouldUpdatePopups = oldShouldUpdatePopups;
 	}
 }
 
@@ -1674,26 +1729,167 @@ void Frame::pastePop()
 {
 	if (!warnIfBufferIsReadOnly()) return;
 	
+	// Replacing the pasted text is one edit
+	beginTransaction();
 	deleteTextPointToMark(false);
 	killRingPointer -= 1;
 	
 	if (killRingPointer < 0)
 	{
 		killRingPointer = killRing.size() - 1;
-		
-		if (killRing.size() == 0)
+	}
+	
+	if (killRing.size() > 0)
+	{
+		paste();
+	}
+
+	commitTransaction();
+}
+
+void Frame::copyRectangle(unsigned int tabWidth, bool shouldDelete)
+{
+	if (shouldDelete && !warnIfBufferIsReadOnly()) return;
+
+	unsigned int firstLine = std::min(point.line, mark.line);
+	unsigned int lastLine = std::max(point.line, mark.line);
+	unsigned int pointColumn = getVisualColumn(currentBuffer->data[point.line], point.col, tabWidth);
+	unsigned int markColumn = getVisualColumn(currentBuffer->data[mark.line], mark.col, tabWidth);
+	unsigned int leftColumn = std::min(pointColumn, markColumn);
+	unsigned int rightColumn = std::max(pointColumn, markColumn);
+
+	if (shouldDelete)
+	{
+		std::vector<std::string_view> texts(lastLine - firstLine + 1);
+		killedRectangle = replaceRectangle(firstLine, leftColumn, rightColumn, tabWidth, texts);
+
+		return;
+	}
+
+	std::string regionText = currentBuffer->substrFromPoints(Point { firstLine, 0 }, Point { lastLine, (unsigned int) currentBuffer->data[lastLine].size() });
+	killedRectangle.clear();
+
+	for (std::string_view line : splitIntoLines(regionText))
+	{
+		RectangleSlice slice = sliceRectangle(line, leftColumn, rightColumn, tabWidth);
+		slice.text.resize(rightColumn - leftColumn, ' ');
+		killedRectangle.push_back(std::move(slice.text));
+	}
+}
+
+void Frame::yankRectangle(unsigned int tabWidth)
+{
+	if (!warnIfBufferIsReadOnly()) return;
+
+	if (killedRectangle.size() == 0)
+	{
+		writeToMinibuffer("Error: No rectangle to yank.");
+		return;
+	}
+
+	unsigned int firstLine = point.line;
+	unsigned int leftColumn = getVisualColumn(currentBuffer->data[point.line], point.col, tabWidth);
+	unsigned int numberOfLines = currentBuffer->data.size();
+	std::vector<std::string_view> texts(killedRectangle.begin(), killedRectangle.end());
+
+	beginTransaction();
+
+	// The rectangle can go past the end of the buffer
+	if (firstLine + texts.size() > numberOfLines)
+	{
+		Point bufferEnd { numberOfLines - 1, (unsigned int) currentBuffer->data[numberOfLines - 1].size(), currentBuffer };
+		currentBuffer->insertText(bufferEnd, std::string(firstLine + texts.size() - numberOfLines, '\n'));
+	}
+
+	replaceRectangle(firstLine, leftColumn, leftColumn, tabWidth, texts);
+	commitTransaction();
+}
+
+void Frame::stringRectangle(std::string_view text, unsigned int tabWidth, bool replacesRectangle)
+{
+	if (!warnIfBufferIsReadOnly()) return;
+
+	unsigned int firstLine = std::min(point.line, mark.line);
+	unsigned int lastLine = std::max(point.line, mark.line);
+	unsigned int pointColumn = getVisualColumn(currentBuffer->data[point.line], point.col, tabWidth);
+	unsigned int markColumn = getVisualColumn(currentBuffer->data[mark.line], mark.col, tabWidth);
+	unsigned int leftColumn = std::min(pointColumn, markColumn);
+	unsigned int rightColumn = replacesRectangle ? std::max(pointColumn, markColumn) : leftColumn;
+
+	std::vector<std::string_view> texts(lastLine - firstLine + 1, text);
+	replaceRectangle(firstLine, leftColumn, rightColumn, tabWidth, texts);
+}
+
+std::vector<std::string> Frame::replaceRectangle(unsigned int firstLine, unsigned int leftColumn, unsigned int rightColumn, unsigned int tabWidth, const std::vector<std::string_view>& texts)
+{
+	// NOTE(fkp): The lines are read in one go, going through the piece
+	// table for each one would be slower.
+	unsigned int lastLine = firstLine + (unsigned int) texts.size() - 1;
+	std::string regionText = currentBuffer->substrFromPoints(Point { firstLine, 0 }, Point { lastLine, (unsigned int) currentBuffer->data[lastLine].size() });
+	std::vector<std::string_view> lines = splitIntoLines(regionText);
+
+	std::vector<std::string> oldTexts;
+	std::vector<LineEdit> edits;
+	unsigned int firstCol = 0;
+	unsigned int lastCol = 0;
+
+	oldTexts.reserve(texts.size());
+	edits.reserve(texts.size());
+
+	for (unsigned int i = 0; i < texts.size(); i++)
+	{
+		RectangleSlice slice = sliceRectangle(lines[i], leftColumn, rightColumn, tabWidth);
+		LineEdit edit;
+		edit.startCol = slice.startCol;
+		edit.endCol = slice.endCol;
+
+		// NOTE(fkp): When nothing comes after the rectangle the padding
+		// would only be trailing spaces, so it's left out. Spaces in the
+		// text itself are always kept.
+		bool isAtEndOfLine = slice.endCol == lines[i].size();
+
+		if (!isAtEndOfLine || !texts[i].empty())
 		{
-			return;
+			edit.text.append(slice.paddingBefore, ' ');
 		}
+
+		edit.text.append(texts[i]);
+		unsigned int textEnd = (unsigned int) edit.text.size();
+
+		if (!isAtEndOfLine)
+		{
+			edit.text.append(slice.paddingAfter, ' ');
+		}
+
+		if (i == 0) firstCol = slice.startCol + std::min(slice.paddingBefore, textEnd);
+		if (i == texts.size() - 1) lastCol = slice.startCol + textEnd;
+
+		slice.text.resize(rightColumn - leftColumn, ' ');
+		oldTexts.push_back(std::move(slice.text));
+		edits.push_back(std::move(edit));
 	}
-	
-	paste();
+
+	beginTransaction();
+	currentBuffer->editLines(firstLine, edits);
+
+	mark = Point { firstLine, firstCol, currentBuffer };
+	point = Point { lastLine, lastCol, currentBuffer };
+	point.targetCol = point.col;
+	doCommonPointManipulationTasks();
+	commitTransaction();
+
+	return oldTexts;
 }
 
 void advanceToNextTabStop(unsigned int tabWidth, const Font* font, float& x, unsigned int& numberOfColumnsInLine)
 {
 	// TODO(fkp): This doesn't work with non-monopspaced fonts
-	unsigned int numberOfColumnsToNextTabStop = tabWidth - (numberOfColumnsInLine % tabWidth);
+	unsigned int numberOfColumnsToNextTabStop = getNumberOfColumnsToNextTabStop(tabWidth, numberOfColumnsInLine);
 	x += font->chars[(unsigned char) ' '].advanceX * numberOfColumnsToNextTabStop;
 	numberOfColumnsInLine += numberOfColumnsToNextTabStop;
 }
+
+unsigned int getNumberOfColumnsToNextTabStop(unsigned int tabWidth, unsigned int numberOfColumnsInLine)
+{
+	return tabWidth - (numberOfColumnsInLine % tabWidth);
+}
@@ -0,0 +1,276 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdio.h>
+
+#include "journal.hpp"
+#include "file_util.hpp"
+
+Journal::FileIdentity Journal::getFileIdentity(const std::string& filePath)
+{
+	FileIdentity identity;
+	std::error_code error;
+
+	std::uint64_t size = std::filesystem::file_size(filePath, error);
+	if (error) return identity;
+
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(filePath, error);
+	if (error) return identity;
+
+	identity.size = size;
+	identity.writeTime = (std::int64_t) writeTime.time_since_epoch().count();
+
+	return identity;
+}
+
+std::string Journal::getJournalPath(const std::string& filePath)
+{
+	return filePath + FILE_EXTENSION;
+}
+
+bool Journal::read(const std::string& filePath, std::vector<Action>& actions)
+{
+	std::string journalPath = getJournalPath(filePath);
+
+	if (!doesFileExist(journalPath.c_str()))
+	{
+		return false;
+	}
+
+	// NOTE(fkp): This can't use readFile(), it adds a newline to the end
+	std::ifstream journalFile(journalPath, std::ios::binary);
+	std::string contents;
+
+	journalFile.seekg(0, std::ios::end);
+	contents.resize((std::size_t) journalFile.tellg());
+	journalFile.seekg(0);
+	journalFile.read(&contents[0], contents.size());
+	contents.resize((std::size_t) journalFile.gcount());
+
+	const char* current = contents.data();
+	const char* end = current + contents.size();
+
+	FileIdentity identity;
+
+	if (end - current < (std::ptrdiff_t) (sizeof(MAGIC) + sizeof(identity.size) + sizeof(identity.writeTime)) ||
+		std::memcmp(current, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		printf("Error: Journal '%s' is not valid.\n", journalPath.c_str());
+		return false;
+	}
+
+	current += sizeof(MAGIC);
+	std::memcpy(&identity.size, current, sizeof(identity.size));
+	current += sizeof(identity.size);
+	std::memcpy(&identity.writeTime, current, sizeof(identity.writeTime));
+	current += sizeof(identity.writeTime);
+
+	if (!(identity == getFileIdentity(filePath)))
+	{
+		printf("Info: Ignoring journal '%s', the file has changed since it was written.\n", journalPath.c_str());
+		return false;
+	}
+
+	actions.clear();
+
+	while (current < end)
+	{
+		ActionType type = *current == 0 ? ActionType::Insertion : ActionType::Deletion;
+		const char* recordStart = current;
+		current += 1;
+
+		std::uint64_t line;
+		std::uint64_t col;
+		std::uint64_t size;
+
+		if (!readVarint(current, end, line) || !readVarint(current, end, col) ||
+			!readVarint(current, end, size) || (std::uint64_t) (end - current) < size)
+		{
+			// The last record was only partly written
+			printf("Info: Journal '%s' ends with an incomplete record at %zu.\n", journalPath.c_str(), (std::size_t) (recordStart - contents.data()));
+			break;
+		}
+
+		Action action;
+		action.type = type;
+		action.start.line = (unsigned int) line;
+		action.start.col = (unsigned int) col;
+		action.data.assign(current, (std::size_t) size);
+		current += size;
+
+		actions.push_back(std::move(action));
+	}
+
+	return true;
+}
+
+void Journal::reset(const std::string& filePath, bool shouldKeepOldFile)
+{
+	if (shouldKeepOldFile)
+	{
+		close();
+		journalPath = getJournalPath(filePath);
+		baseFile = getFileIdentity(filePath);
+
+		return;
+	}
+
+	// Both the old journal and anything already at the new path are
+	// out of date now.
+	discard();
+	journalPath = getJournalPath(filePath);
+	discard();
+
+	baseFile = getFileIdentity(filePath);
+}
+
+void Journal::discard()
+{
+	close();
+
+	if (journalPath != "" && doesFileExist(journalPath.c_str()))
+	{
+		std::remove(journalPath.c_str());
+	}
+}
+
+void Journal::close()
+{
+	if (file.is_open())
+	{
+		file.close();
+	}
+
+	unflushedRecords.clear();
+	numberOfRecords = 0;
+	isKeepingRecordsSinceSave = false;
+	recordsSinceSave.clear();
+	numberOfRecordsSinceSave = 0;
+}
+
+void Journal::append(ActionType type, const Point& start, std::string_view text)
+{
+	if (journalPath == "")
+	{
+		return;
+	}
+
+	std::size_t recordStart = unflushedRecords.size();
+
+	// type, start line, start col, size, data. The end point can be
+	// worked out from the data.
+	unflushedRecords += type == ActionType::Insertion ? '\0' : '\1';
+	writeVarint(unflushedRecords, start.line);
+	writeVarint(unflushedRecords, start.col);
+
+	// NOTE(fkp): Pasted text can have '\r's in it, but they are never
+	// actually inserted.
+	writeVarint(unflushedRecords, text.size() - std::count(text.begin(), text.end(), '\r'));
+
+	for (char character : text)
+	{
+		if (character != '\r')
+		{
+			unflushedRecords += character;
+		}
+	}
+	numberOfRecords += 1;
+
+	if (isKeepingRecordsSinceSave)
+	{
+		recordsSinceSave.append(unflushedRecords, recordStart, std::string::npos);
+		numberOfRecordsSinceSave += 1;
+	}
+}
+
+void Journal::flush()
+{
+	if (unflushedRecords.size() == 0)
+	{
+		return;
+	}
+
+	if (!file.is_open())
+	{
+		file.open(journalPath, std::ios::binary | std::ios::trunc);
+
+		if (!file)
+		{
+			printf("Error: Failed to open journal '%s'.\n", journalPath.c_str());
+			unflushedRecords.clear();
+
+			return;
+		}
+
+		file.write(MAGIC, sizeof(MAGIC));
+		file.write((const char*) &baseFile.size, sizeof(baseFile.size));
+		file.write((const char*) &baseFile.writeTime, sizeof(baseFile.writeTime));
+	}
+
+	file.write(unflushedRecords.data(), unflushedRecords.size());
+	file.flush();
+	unflushedRecords.clear();
+}
+
+void Journal::startSave()
+{
+	isKeepingRecordsSinceSave = true;
+	recordsSinceSave.clear();
+	numberOfRecordsSinceSave = 0;
+}
+
+void Journal::finishSave(const std::string& filePath, bool wasSuccessful)
+{
+	if (!wasSuccessful)
+	{
+		isKeepingRecordsSinceSave = false;
+		recordsSinceSave.clear();
+		numberOfRecordsSinceSave = 0;
+
+		return;
+	}
+
+	// NOTE(fkp): The edits made while saving are already in the buffer
+	// but not in the file, so they are moved to the new journal.
+	std::string records = std::move(recordsSinceSave);
+	unsigned int numberOfUnsavedRecords = numberOfRecordsSinceSave;
+	reset(filePath);
+
+	if (records.size() > 0)
+	{
+		unflushedRecords = std::move(records);
+		numberOfRecords = numberOfUnsavedRecords;
+		flush();
+	}
+}
+
+void Journal::writeVarint(std::string& output, std::uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		output += (char) ((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+
+	output += (char) value;
+}
+
+bool Journal::readVarint(const char*& current, const char* end, std::uint64_t& value)
+{
+	value = 0;
+
+	for (unsigned int shift = 0; current < end && shift < 64; shift += 7)
+	{
+		unsigned char byte = (unsigned char) *current++;
+		value |= (std::uint64_t) (byte & 0x7F) << shift;
+
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
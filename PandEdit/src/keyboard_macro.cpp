@@ -0,0 +1,194 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+
+#include "keyboard_macro.hpp"
+#include "commands.hpp"
+#include "frame.hpp"
+#include "window.hpp"
+
+void KeyboardMacro::start()
+{
+	stepsBeingRecorded.clear();
+	isRecording = true;
+}
+
+bool KeyboardMacro::end(bool wasEndedFromMinibuffer)
+{
+	if (!isRecording)
+	{
+		return false;
+	}
+
+	// NOTE(fkp): The minibuffer being opened (and everything typed
+	// into it) to end the macro isn't part of it.
+	if (wasEndedFromMinibuffer)
+	{
+		while (stepsBeingRecorded.size() > 0)
+		{
+			bool isMinibufferEnter = stepsBeingRecorded.back().commandText == "minibufferEnter";
+			stepsBeingRecorded.pop_back();
+
+			if (isMinibufferEnter) break;
+		}
+	}
+
+	steps = std::move(stepsBeingRecorded);
+	stepsBeingRecorded.clear();
+	isRecording = false;
+
+	return true;
+}
+
+unsigned int KeyboardMacro::getNumberOfSteps()
+{
+	return (unsigned int) steps.size();
+}
+
+void KeyboardMacro::recordCommand(const std::string& commandText, bool shortcut)
+{
+	if (!isRecording || isReplaying)
+	{
+		return;
+	}
+
+	// The macro commands themselves are left out
+	std::string commandName = commandText.substr(0, commandText.find(' '));
+
+	if (commandName == "startMacro" || commandName == "endMacro" ||
+		commandName == "replayMacro" || commandName == "replayMacroOnRegionLines")
+	{
+		return;
+	}
+
+	Step step;
+	step.commandText = commandText;
+	step.shortcut = shortcut;
+	stepsBeingRecorded.push_back(std::move(step));
+}
+
+void KeyboardMacro::recordChar(char character)
+{
+	if (!isRecording || isReplaying)
+	{
+		return;
+	}
+
+	Step step;
+	step.character = character;
+	stepsBeingRecorded.push_back(std::move(step));
+}
+
+std::size_t KeyboardMacro::replay(Window& window, unsigned int numberOfTimes)
+{
+	if (steps.size() == 0 || isRecording)
+	{
+		return 0;
+	}
+
+	Frame* frame = Frame::currentFrame;
+	Buffer* buffer = frame->currentBuffer;
+	std::size_t numberOfStepsRun = 0;
+
+	isReplaying = true;
+	frame->beginTransaction();
+
+	for (unsigned int i = 0; i < numberOfTimes; i++)
+	{
+		std::size_t numberRun = runSteps(window, frame, buffer);
+		numberOfStepsRun += numberRun;
+
+		if (numberRun < steps.size()) break;
+	}
+
+	frame->commitTransaction();
+	isReplaying = false;
+
+	return numberOfStepsRun;
+}
+
+std::size_t KeyboardMacro::replayOnLines(Window& window, unsigned int firstLine, unsigned int lastLine)
+{
+	if (steps.size() == 0 || isRecording)
+	{
+		return 0;
+	}
+
+	Frame* frame = Frame::currentFrame;
+	Buffer* buffer = frame->currentBuffer;
+	std::size_t numberOfStepsRun = 0;
+
+	// These follow the lines around as the macro edits them
+	Point nextLineStart { firstLine, 0, buffer };
+	Point lastLineStart { lastLine, 0, buffer };
+	buffer->anchors.add(&nextLineStart, AnchorGravity::Right);
+	buffer->anchors.add(&lastLineStart, AnchorGravity::Right);
+
+	isReplaying = true;
+	frame->beginTransaction();
+
+	unsigned int line = firstLine;
+
+	while (line <= lastLineStart.line && line < buffer->data.size() &&
+		   frame->currentBuffer == buffer)
+	{
+		nextLineStart.line = line + 1;
+		nextLineStart.col = 0;
+
+		frame->point.line = line;
+		frame->point.col = 0;
+		frame->point.targetCol = 0;
+
+		std::size_t numberRun = runSteps(window, frame, buffer);
+		numberOfStepsRun += numberRun;
+
+		if (numberRun < steps.size()) break;
+
+		// NOTE(fkp): Always moves forward, even if the macro deleted
+		// the start of the next line.
+		line = std::max(line + 1, nextLineStart.line);
+	}
+
+	frame->commitTransaction();
+	isReplaying = false;
+
+	buffer->anchors.remove(&nextLineStart);
+	buffer->anchors.remove(&lastLineStart);
+
+	return numberOfStepsRun;
+}
+
+std::size_t KeyboardMacro::runSteps(Window& window, Frame* frame, Buffer* buffer)
+{
+	std::size_t numberOfStepsRun = 0;
+
+	for (const Step& step : steps)
+	{
+		// NOTE(fkp): The transaction belongs to the buffer it was started
+		// on, so nothing can be replayed anywhere else. Steps can still
+		// go through the minibuffer (to search or run a command).
+		bool isInOtherFrame = Frame::currentFrame != frame && Frame::currentFrame != Frame::minibufferFrame;
+
+		if (isInOtherFrame || frame->currentBuffer != buffer)
+		{
+			break;
+		}
+
+		if (step.commandText != "")
+		{
+			Commands::executeCommand(window, step.commandText, step.shortcut);
+		}
+		else if (step.character == '\n')
+		{
+			Frame::currentFrame->newLine();
+		}
+		else
+		{
+			Frame::currentFrame->insertChar(step.character);
+		}
+
+		numberOfStepsRun += 1;
+	}
+
+	return numberOfStepsRun;
+}
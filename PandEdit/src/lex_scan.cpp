@@ -0,0 +1,198 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEX_SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LEX_SCAN_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "lex_scan.hpp"
+
+static unsigned int countTrailingZeros(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static bool isIdentifierCharacter(char character)
+{
+	return (character >= 'a' && character <= 'z') ||
+		   (character >= 'A' && character <= 'Z') ||
+		   (character >= '0' && character <= '9') ||
+		   character == '_';
+}
+
+#if defined(LEX_SCAN_AVX2)
+static constexpr int BLOCK_SIZE = 32;
+using Block = __m256i;
+
+static Block load(const char* current) { return _mm256_loadu_si256((const __m256i*) current); }
+static Block splat(char character) { return _mm256_set1_epi8(character); }
+static Block equals(Block left, Block right) { return _mm256_cmpeq_epi8(left, right); }
+static Block greaterThan(Block left, Block right) { return _mm256_cmpgt_epi8(left, right); }
+static Block either(Block left, Block right) { return _mm256_or_si256(left, right); }
+static Block both(Block left, Block right) { return _mm256_and_si256(left, right); }
+static unsigned int getMask(Block block) { return (unsigned int) _mm256_movemask_epi8(block); }
+static constexpr unsigned int FULL_MASK = 0xFFFFFFFF;
+#elif defined(LEX_SCAN_SSE2)
+static constexpr int BLOCK_SIZE = 16;
+using Block = __m128i;
+
+static Block load(const char* current) { return _mm_loadu_si128((const __m128i*) current); }
+static Block splat(char character) { return _mm_set1_epi8(character); }
+static Block equals(Block left, Block right) { return _mm_cmpeq_epi8(left, right); }
+static Block greaterThan(Block left, Block right) { return _mm_cmpgt_epi8(left, right); }
+static Block either(Block left, Block right) { return _mm_or_si128(left, right); }
+static Block both(Block left, Block right) { return _mm_and_si128(left, right); }
+static unsigned int getMask(Block block) { return (unsigned int) _mm_movemask_epi8(block); }
+static constexpr unsigned int FULL_MASK = 0xFFFF;
+#endif
+
+#if defined(LEX_SCAN_AVX2) || defined(LEX_SCAN_SSE2)
+// NOTE(fkp): The comparisons are signed, so anything above 0x7F is
+// negative and never ends up inside one of these ranges.
+static Block isInRange(Block block, char low, char high)
+{
+	return both(greaterThan(block, splat(low - 1)), greaterThan(splat(high + 1), block));
+}
+#endif
+
+const char* findBlockCommentEnd(const char* start, const char* end)
+{
+	const char* current = start;
+
+#if defined(LEX_SCAN_AVX2) || defined(LEX_SCAN_SSE2)
+	const Block stars = splat('*');
+	const Block slashes = splat('/');
+
+	// Each block is compared with the one a character after it, so
+	// there has to be one more character than a block.
+	for (; end - current > BLOCK_SIZE; current += BLOCK_SIZE)
+	{
+		unsigned int mask = getMask(both(equals(load(current), stars), equals(load(current + 1), slashes)));
+
+		if (mask != 0)
+		{
+			return current + countTrailingZeros(mask);
+		}
+	}
+#endif
+
+	for (; end - current >= 2; current++)
+	{
+		if (current[0] == '*' && current[1] == '/')
+		{
+			return current;
+		}
+	}
+
+	return end;
+}
+
+const char* findQuoteOrBackslash(const char* start, const char* end)
+{
+	const char* current = start;
+
+#if defined(LEX_SCAN_AVX2) || defined(LEX_SCAN_SSE2)
+	const Block quotes = splat('"');
+	const Block backslashes = splat('\\');
+
+	for (; end - current >= BLOCK_SIZE; current += BLOCK_SIZE)
+	{
+		Block block = load(current);
+		unsigned int mask = getMask(either(equals(block, quotes), equals(block, backslashes)));
+
+		if (mask != 0)
+		{
+			return current + countTrailingZeros(mask);
+		}
+	}
+#endif
+
+	for (; current < end; current++)
+	{
+		if (*current == '"' || *current == '\\')
+		{
+			return current;
+		}
+	}
+
+	return end;
+}
+
+const char* skipWhitespace(const char* start, const char* end)
+{
+	const char* current = start;
+
+#if defined(LEX_SCAN_AVX2) || defined(LEX_SCAN_SSE2)
+	const Block spaces = splat(' ');
+	const Block tabs = splat('\t');
+
+	for (; end - current >= BLOCK_SIZE; current += BLOCK_SIZE)
+	{
+		Block block = load(current);
+		unsigned int mask = ~getMask(either(equals(block, spaces), equals(block, tabs))) & FULL_MASK;
+
+		if (mask != 0)
+		{
+			return current + countTrailingZeros(mask);
+		}
+	}
+#endif
+
+	for (; current < end; current++)
+	{
+		if (*current != ' ' && *current != '\t')
+		{
+			return current;
+		}
+	}
+
+	return end;
+}
+
+const char* skipIdentifierCharacters(const char* start, const char* end)
+{
+	const char* current = start;
+
+#if defined(LEX_SCAN_AVX2) || defined(LEX_SCAN_SSE2)
+	// Setting 0x20 turns uppercase letters into lowercase ones, and
+	// nothing else into a letter.
+	const Block caseBits = splat(0x20);
+	const Block underscores = splat('_');
+
+	for (; end - current >= BLOCK_SIZE; current += BLOCK_SIZE)
+	{
+		Block block = load(current);
+		Block letters = isInRange(either(block, caseBits), 'a', 'z');
+		Block digits = isInRange(block, '0', '9');
+		unsigned int mask = ~getMask(either(either(letters, digits), equals(block, underscores))) & FULL_MASK;
+
+		if (mask != 0)
+		{
+			return current + countTrailingZeros(mask);
+		}
+	}
+#endif
+
+	for (; current < end; current++)
+	{
+		if (!isIdentifierCharacter(*current))
+		{
+			return current;
+		}
+	}
+
+	return end;
+}
@@ -0,0 +1,191 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+#include <cstdint>
+
+#include "lex_worker.hpp"
+#include "buffer.hpp"
+#include "region_transforms.hpp"
+#include "run_on_threads.hpp"
+
+LexWorker::~LexWorker()
+{
+	stop();
+	waitUntilFinished();
+}
+
+void LexWorker::start(const Buffer* buffer, unsigned int startLine, std::string&& text, LineLexState::FinishType finishTypeBefore)
+{
+	firstLine = startLine;
+	this->finishTypeBefore = finishTypeBefore;
+	lineStates.clear();
+	chunkFirstLines.clear();
+	wasSuccessful = false;
+	timer.reset();
+
+	isThreadDone = false;
+	shouldStop = false;
+	lexThread = std::thread(&LexWorker::lex, this, buffer, std::move(text));
+}
+
+void LexWorker::stop()
+{
+	shouldStop = true;
+}
+
+void LexWorker::waitUntilFinished()
+{
+	if (lexThread.joinable())
+	{
+		lexThread.join();
+	}
+}
+
+bool LexWorker::isFinished() const
+{
+	return isThreadDone;
+}
+
+std::vector<LineLexState> LexWorker::takeLineStates()
+{
+	waitUntilFinished();
+	return std::move(lineStates);
+}
+
+void LexWorker::shiftLines(int numberOfLines)
+{
+	if (numberOfLines == 0)
+	{
+		return;
+	}
+
+	waitUntilFinished();
+	firstLine += numberOfLines;
+
+	for (unsigned int& chunkFirstLine : chunkFirstLines)
+	{
+		chunkFirstLine += numberOfLines;
+	}
+
+	for (LineLexState& lineState : lineStates)
+	{
+		for (Token& token : lineState.tokens)
+		{
+			token.start.line += numberOfLines;
+			token.end.line += numberOfLines;
+		}
+	}
+}
+
+// NOTE(fkp): This runs on its own thread
+void LexWorker::lex(const Buffer* buffer, std::string text)
+{
+	// NOTE(fkp): Each chunk is copied with the line before it (except
+	// the first line of the buffer), which only gives how that line
+	// finished. The first chunk is the only one where that's known.
+	std::vector<std::string_view> lines = splitIntoLines(text);
+	unsigned int numberOfLinesBefore = firstLine > 0 ? 1 : 0;
+	unsigned int numberOfLinesToLex = (unsigned int) lines.size() - numberOfLinesBefore;
+	unsigned int numberOfChunks = std::max(1u, std::min(std::thread::hardware_concurrency(), numberOfLinesToLex / MIN_LINES_PER_THREAD));
+
+	std::vector<unsigned int> chunkStarts;
+
+	for (unsigned int i = 0; i <= numberOfChunks; i++)
+	{
+		chunkStarts.push_back(numberOfLinesBefore + (unsigned int) ((std::uint64_t) numberOfLinesToLex * i / numberOfChunks));
+	}
+
+	// The copies aren't registered anywhere, so nothing else can see them
+	std::vector<std::unique_ptr<Buffer>> chunks;
+
+	for (unsigned int i = 0; i < numberOfChunks; i++)
+	{
+		chunks.push_back(std::make_unique<Buffer>(BufferType::Snapshot, "", ""));
+	}
+
+	runOnThreads(numberOfChunks, [&](std::size_t chunk)
+				 {
+					 unsigned int firstCopiedLine = chunkStarts[chunk] > 0 ? chunkStarts[chunk] - 1 : 0;
+					 const char* start = lines[firstCopiedLine].data();
+					 const char* end = lines[chunkStarts[chunk + 1] - 1].data() + lines[chunkStarts[chunk + 1] - 1].size();
+
+					 Buffer& snapshot = *chunks[chunk];
+					 snapshot.data.loadFromString(std::string(start, end));
+					 snapshot.lexer.stopFlag = &shouldStop;
+					 snapshot.lexer.lineStates.resize(snapshot.data.size());
+
+					 // NOTE(fkp): The others are guessed, most chunks start outside
+					 // of any string or comment.
+					 if (chunk == 0 && numberOfLinesBefore > 0)
+					 {
+						 snapshot.lexer.lineStates[0].finishType = finishTypeBefore;
+					 }
+
+					 snapshot.lexer.lex(chunkStarts[chunk] > 0 ? 1 : 0, false, true);
+				 });
+
+	std::string().swap(text);
+
+	if (shouldStop || !stitchChunks(chunks))
+	{
+		elapsedMs = timer.getElapsedMs();
+		isThreadDone = true;
+
+		return;
+	}
+
+	lineStates.reserve(numberOfLinesToLex);
+
+	for (unsigned int i = 0; i < numberOfChunks; i++)
+	{
+		std::vector<LineLexState>& chunkLineStates = chunks[i]->lexer.lineStates;
+		unsigned int numberOfCopiedLinesBefore = chunkStarts[i] > 0 ? 1 : 0;
+
+		// The tokens are moved to where the lines are in the real buffer
+		unsigned int chunkFirstLine = firstLine + chunkStarts[i] - numberOfLinesBefore;
+		unsigned int lineOffset = chunkFirstLine - numberOfCopiedLinesBefore;
+		chunkFirstLines.push_back(chunkFirstLine);
+
+		for (unsigned int line = numberOfCopiedLinesBefore; line < chunkLineStates.size(); line++)
+		{
+			for (Token& token : chunkLineStates[line].tokens)
+			{
+				token.start.line += lineOffset;
+				token.start.buffer = buffer;
+				token.end.line += lineOffset;
+				token.end.buffer = buffer;
+			}
+
+			lineStates.push_back(std::move(chunkLineStates[line]));
+		}
+	}
+
+	wasSuccessful = true;
+	elapsedMs = timer.getElapsedMs();
+	isThreadDone = true;
+}
+
+bool LexWorker::stitchChunks(std::vector<std::unique_ptr<Buffer>>& chunks)
+{
+	for (std::size_t i = 1; i < chunks.size(); i++)
+	{
+		Lexer& lexer = chunks[i]->lexer;
+		LineLexState::FinishType finishType = chunks[i - 1]->lexer.lineStates.back().finishType;
+
+		if (lexer.lineStates[0].finishType == finishType)
+		{
+			continue;
+		}
+
+		// NOTE(fkp): This stops once the lines finish the way they did
+		// before, if that never happens the next chunk is wrong as well.
+		lexer.lineStates[0].finishType = finishType;
+
+		if (!lexer.lex(1, false, false, 1))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
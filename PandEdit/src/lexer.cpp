@@ -7,49 +7,8 @@
 #include "buffer.hpp"
 #include "common.hpp"
 #include "colour.hpp"
-
-// 1. NOTE(fkp): These are only keywords in some contexts
-std::unordered_set<std::string> Lexer::keywords = {
-	"alignas", "alignof", "sizeof", "typeid", "decltype",
-	
-	"and", "and_eq", "bitand", "bitor", "compl",
-	"not", "not_eq", "or", "or_eq", "xor", "xor_eq",
-	
-	"atomic_cancel", "atomic_commit", "atomic_noexcept",
-
-	"break", "case", "continue", "default", "do", "else",
-	"for", "goto", "if", "return", "switch", "while",
-
-	"const", "consteval", "constexpr", "constinit", "const_cast",
-	
-	"auto", "class", "delete", "enum", "explicit", "final" /* note 1 */,
-	"friend", "inline", "mutable", "namespace", "new", "noexcept",
-	"operator", "override" /* note 1 */, "private", "protected",
-	"public", "struct", "template", "this", "typedef", "typename",
-	"union", "using", "virtual", "volatile",
-
-	"catch", "throw", "try",
-	
-	"co_await", "co_return", "co_yield", "synchronized", "thread_local",
-
-	"concept", "export", "import" /* note 1 */,
-	"module" /* note 1 */, "requires",
-	
-	"extern", "register", "static",
-
-	"dynamic_cast", "reinterpret_cast", "static_assert", "static_cast",
-	
-	"asm", "reflexpr",
-};
-
-std::unordered_set<std::string> Lexer::primitiveTypes = {
-	"bool",
-	"char", "char8_t", "char16_t", "char32_t", "wchar_t",
-	"double", "float",
-	"int", "long", "short",
-	"signed", "unsigned",
-	"false", "nullptr", "true", "void",
-};
+#include "keyword_table.hpp"
+#include "lex_scan.hpp"
 
 Lexer::Lexer(Buffer* buffer)
 	: buffer(buffer)
@@ -63,31 +22,36 @@ Lexer::Lexer(Buffer* buffer)
 #define LINE_STATE lineStates[point.line]
 #define LINE_TOKENS lineStates[point.line].tokens
 
-void Lexer::lex(unsigned int startLine, bool lexEntireBuffer)
+bool Lexer::lex(unsigned int startLine, bool lexEntireBuffer, bool lexToEnd, unsigned int lexUntilLine, unsigned int stopLine)
 {
+	this->stopLine = stopLine;
+	hasStoppedEarly = false;
+
 	// If lexing the entire buffer, clear old memory
 	if (lexEntireBuffer)
 	{
 		lineStates.clear();
+		clearFunctionDefinitions();
 	}
 	
 	if (buffer->data.size() == 0)
 	{
 		ERROR_ONCE("Error: Buffer has no lines in it.\n");
-		return;
+		return true;
 	}
 	else if (buffer->data.size() == 1 && buffer->data[0].size() == 0)
 	{
 		lineStates.clear();
 		lineStates.emplace_back();
+		clearFunctionDefinitions();
 
-		return;
+		return true;
 	}
 
 	if (lineStates.size() > buffer->data.size())
 	{
 		ERROR_ONCE("Error: More line states than buffer lines.\n");
-		return;
+		return true;
 	}
 	
 	while (lineStates.size() < buffer->data.size())
@@ -103,6 +67,11 @@ void Lexer::lex(unsigned int startLine, bool lexEntireBuffer)
 	{
 		if (point.col == 0)
 		{
+			if (shouldStop(point.line))
+			{
+				break;
+			}
+
 			LINE_TOKENS.clear();
 
 			if (point.line > 0)
@@ -118,7 +87,7 @@ void Lexer::lex(unsigned int startLine, bool lexEntireBuffer)
 			}
 		}
 
-		if (!point.isInBuffer())
+		if (!point.isInBuffer() || hasStoppedEarly)
 		{
 			break;
 		}
@@ -186,7 +155,7 @@ void Lexer::lex(unsigned int startLine, bool lexEntireBuffer)
 				lineStates[point.line].finishType = LineLexState::FinishType::Finished;
 
 				if (lineStates[point.line].finishType == currentLineLastFinishType &&
-					!lexEntireBuffer)
+					!lexEntireBuffer && !lexToEnd && point.line >= lexUntilLine)
 				{
 					goto FINISHED_LEX;
 				}
@@ -194,33 +163,49 @@ void Lexer::lex(unsigned int startLine, bool lexEntireBuffer)
 				{
 					point.moveNext(true);
 					
-					if (point.isInBuffer())
+					if (point.isInBuffer() && !shouldStop(point.line))
 					{
 						LINE_TOKENS.clear();
 					}
 				}
 			}
+			else if (isUsingVectorScanning && (character == ' ' || character == '\t'))
+			{
+				LineView line = buffer->data[point.line];
+				point.col = (unsigned int) (skipWhitespace(line.data() + point.col, line.data() + line.size()) - line.data());
+			}
 			else if (character >= '0' && character <= '9')
 			{
 				lexNumber(point);
 			}
 			else if (isIdentifierStartCharacter(character))
 			{
+				// NOTE(fkp): Identifiers never span lines, so this
+				// scans the line directly rather than moving the point
+				// one character at a time and copying the text.
 				Point startPoint = point;
-				std::string tokenText;
-				char character;
-				UPDATE_CHARACTER();
+				LineView line = buffer->data[point.line];
+				unsigned int endCol = point.col + 1;
 
-				do
+				if (isUsingVectorScanning)
 				{
-					tokenText += character;
-					point.moveNext();
-					UPDATE_CHARACTER();
-				} while (isIdentifierCharacter(character));
-				
-				if (!lexKeyword(startPoint, point, tokenText))
+					endCol = (unsigned int) (skipIdentifierCharacters(line.data() + endCol, line.data() + line.size()) - line.data());
+				}
+				else
 				{
-					lexIdentifier(startPoint, point, tokenText);
+					while (endCol < line.size() && isIdentifierCharacter(line[endCol]))
+					{
+						endCol += 1;
+					}
+				}
+
+				point.col = endCol;
+				std::string_view tokenText = line.substr(startPoint.col, endCol - startPoint.col);
+				KeywordType keywordType = classifyKeyword(tokenText);
+
+				if (!lexKeyword(startPoint, point, tokenText, keywordType))
+				{
+					lexIdentifier(startPoint, point, keywordType);
 				}
 			}
 			else
@@ -235,7 +220,32 @@ void Lexer::lex(unsigned int startLine, bool lexEntireBuffer)
 	}
 
 FINISHED_LEX:
-	doFinalAdjustments();
+	// NOTE(fkp): The lines after this one still have their old tokens,
+	// which have already been adjusted.
+	unsigned int lastLexedLine = std::min<unsigned int>(hasStoppedEarly ? point.line - 1 : point.line, (unsigned int) lineStates.size() - 1);
+
+	if (stopFlag && *stopFlag)
+	{
+		return false;
+	}
+
+	if (lastLexedLine >= startLine)
+	{
+		doFinalAdjustments(startLine, lastLexedLine);
+		updateFunctionDefinitions(startLine, lastLexedLine);
+	}
+
+	return !hasStoppedEarly;
+}
+
+bool Lexer::shouldStop(unsigned int line)
+{
+	if (line > stopLine || (stopFlag && *stopFlag))
+	{
+		hasStoppedEarly = true;
+	}
+
+	return hasStoppedEarly;
 }
 
 void Lexer::addLine(Point splitPoint)
@@ -285,6 +295,7 @@ void Lexer::removeLine(Point newPoint)
 
 	std::move(lineStates[newPoint.line + 1].tokens.begin(), lineStates[newPoint.line + 1].tokens.end(), std::back_inserter(lineStates[newPoint.line].tokens));
 	lineStates[newPoint.line].finishType = lineStates[newPoint.line + 1].finishType;
+	removeFunctionDefinitions(lineStates[newPoint.line + 1]);
 	lineStates.erase(lineStates.begin() + newPoint.line + 1);
 
 	for (int i = newPoint.line + 1; i < buffer->data.size(); i++)
@@ -297,6 +308,152 @@ void Lexer::removeLine(Point newPoint)
 	}
 }
 
+void Lexer::addLines(unsigned int line, unsigned int numberOfLines)
+{
+	if (numberOfLines == 0 || line >= lineStates.size())
+	{
+		return;
+	}
+
+	// NOTE(fkp): The last new line takes over the end of the split line,
+	// so it also finishes the same way.
+	lineStates.insert(lineStates.begin() + line + 1, numberOfLines, LineLexState {});
+	lineStates[line + numberOfLines].finishType = lineStates[line].finishType;
+
+	for (unsigned int i = line + numberOfLines + 1; i < lineStates.size(); i++)
+	{
+		for (Token& token : lineStates[i].tokens)
+		{
+			token.start.line += numberOfLines;
+			token.end.line += numberOfLines;
+		}
+	}
+}
+
+void Lexer::removeLines(unsigned int line, unsigned int numberOfLines)
+{
+	if (numberOfLines == 0 || line + numberOfLines >= lineStates.size())
+	{
+		return;
+	}
+
+	lineStates[line].finishType = lineStates[line + numberOfLines].finishType;
+
+	for (unsigned int i = line + 1; i <= line + numberOfLines; i++)
+	{
+		removeFunctionDefinitions(lineStates[i]);
+	}
+
+	lineStates.erase(lineStates.begin() + line + 1, lineStates.begin() + line + 1 + numberOfLines);
+
+	for (unsigned int i = line + 1; i < lineStates.size(); i++)
+	{
+		for (Token& token : lineStates[i].tokens)
+		{
+			token.start.line -= numberOfLines;
+			token.end.line -= numberOfLines;
+		}
+	}
+}
+
+void Lexer::adjustLines(const std::vector<LineChange>& changes)
+{
+	if (changes.size() == 0)
+	{
+		return;
+	}
+
+	if (changes.back().line + changes.back().numberOfLinesRemoved >= lineStates.size())
+	{
+		ERROR_ONCE("Error: Changed lines are outside of the lexed lines.\n");
+		return;
+	}
+
+	// NOTE(fkp): This goes backwards first so that each change gets the
+	// finish type of the line it joins onto after that line's own change.
+	std::vector<LineLexState::FinishType> addedLinesFinishTypes(changes.size());
+
+	for (std::size_t i = changes.size(); i-- > 0;)
+	{
+		const LineChange& change = changes[i];
+
+		for (unsigned int line = change.line + 1; line <= change.line + change.numberOfLinesRemoved; line++)
+		{
+			removeFunctionDefinitions(lineStates[line]);
+		}
+
+		lineStates[change.line].finishType = lineStates[change.line + change.numberOfLinesRemoved].finishType;
+		addedLinesFinishTypes[i] = lineStates[change.line].finishType;
+	}
+
+	std::vector<LineLexState> newLineStates;
+	newLineStates.reserve(lineStates.size());
+	unsigned int nextLine = 0;
+	long long lineOffset = 0;
+
+	auto moveLinesUntil = [&](unsigned int endLine)
+	{
+		for (; nextLine < endLine; nextLine++)
+		{
+			if (lineOffset != 0)
+			{
+				for (Token& token : lineStates[nextLine].tokens)
+				{
+					token.start.line = (unsigned int) (token.start.line + lineOffset);
+					token.end.line = (unsigned int) (token.end.line + lineOffset);
+				}
+			}
+
+			newLineStates.push_back(std::move(lineStates[nextLine]));
+		}
+	};
+
+	for (std::size_t i = 0; i < changes.size(); i++)
+	{
+		const LineChange& change = changes[i];
+
+		// The line itself stays, unless the change before removed it
+		moveLinesUntil(change.line + 1);
+		nextLine = std::max(nextLine, change.line + change.numberOfLinesRemoved + 1);
+
+		// The last new line takes over the end of the line, like in addLines()
+		if (change.numberOfLinesAdded > 0)
+		{
+			newLineStates.resize(newLineStates.size() + change.numberOfLinesAdded);
+			newLineStates.back().finishType = addedLinesFinishTypes[i];
+		}
+
+		lineOffset += (long long) change.numberOfLinesAdded - (long long) change.numberOfLinesRemoved;
+	}
+
+	moveLinesUntil((unsigned int) lineStates.size());
+	lineStates = std::move(newLineStates);
+}
+
+bool Lexer::replaceLineStates(unsigned int firstLine, std::vector<LineLexState>&& newLineStates, const std::vector<unsigned int>& seams)
+{
+	if (firstLine + newLineStates.size() != lineStates.size())
+	{
+		return false;
+	}
+
+	for (unsigned int i = 0; i < newLineStates.size(); i++)
+	{
+		removeFunctionDefinitions(lineStates[firstLine + i]);
+		lineStates[firstLine + i] = std::move(newLineStates[i]);
+		addFunctionDefinitions(lineStates[firstLine + i]);
+	}
+
+	// The functions were found without the lines before each seam, so
+	// the ones there might go back further.
+	for (unsigned int seam : seams)
+	{
+		updateFunctionDefinitions(seam, seam);
+	}
+
+	return true;
+}
+
 std::vector<Token*> Lexer::getTokens(unsigned int startLine, unsigned int endLine)
 {
 	if (lineStates.size() == 0)
@@ -341,10 +498,22 @@ void Lexer::lexString(Point& point, LineLexState::FinishType& currentLineLastFin
 		// This happens when we go to the next line after an unended string
 		if (point.col == 0)
 		{
+			if (shouldStop(point.line))
+			{
+				break;
+			}
+
 			startPoint = point;
 			LINE_TOKENS.clear();
 			currentLineLastFinishType = lineStates[point.line].finishType;
 		}
+
+		// Only a quote, backslash or the end of the line does anything
+		if (isUsingVectorScanning)
+		{
+			LineView line = buffer->data[point.line];
+			point.col = (unsigned int) (findQuoteOrBackslash(line.data() + point.col, line.data() + line.size()) - line.data());
+		}
 				
 		UPDATE_CHARACTER();
 
@@ -544,10 +713,18 @@ void Lexer::lexLineComment(Point& point)
 {
 	Point startPoint = point;
 
-	do
+	if (isUsingVectorScanning)
 	{
-		point.moveNext(true);
-	} while (point.isInBuffer() && point.col < buffer->data[point.line].size());
+		// NOTE(fkp): Nothing is looked at, so this doesn't even need a scan
+		point.col = (unsigned int) buffer->data[point.line].size();
+	}
+	else
+	{
+		do
+		{
+			point.moveNext(true);
+		} while (point.isInBuffer() && point.col < buffer->data[point.line].size());
+	}
 
 	LINE_TOKENS.emplace_back(Token::Type::LineComment, startPoint, point);
 }
@@ -569,11 +746,23 @@ void Lexer::lexBlockComment(Point& point, LineLexState::FinishType& currentLineL
 		// This happens when we go to the next line after an unended comment
 		if (point.col == 0)
 		{
+			if (shouldStop(point.line))
+			{
+				break;
+			}
+
 			startPoint = point;
 			LINE_TOKENS.clear();
 			currentLineLastFinishType = lineStates[point.line].finishType;
 		}
 
+		// Only the end of the comment or the line does anything
+		if (isUsingVectorScanning)
+		{
+			LineView line = buffer->data[point.line];
+			point.col = (unsigned int) (findBlockCommentEnd(line.data() + point.col, line.data() + line.size()) - line.data());
+		}
+
 		UPDATE_CHARACTER();
 
 		if (character == '*' &&
@@ -653,15 +842,15 @@ void Lexer::lexPreprocessorDirective(Point& point)
 		}
 	} while (isIdentifierCharacter(character) || isspace(character));
 
-	tokenText.erase(std::remove_if(tokenText.begin(), tokenText.end(), isspace));
+	tokenText.erase(std::remove_if(tokenText.begin(), tokenText.end(), isspace), tokenText.end());
 	LINE_TOKENS.emplace_back(Token::Type::PreprocessorDirective, startPoint, point, tokenText);
 }
 
-bool Lexer::lexKeyword(const Point& startPoint, const Point& point, const std::string& tokenText)
+bool Lexer::lexKeyword(const Point& startPoint, const Point& point, std::string_view tokenText, KeywordType keywordType)
 {
-	if (keywords.find(tokenText) != keywords.end())
+	if (keywordType == KeywordType::Keyword)
 	{
-		LINE_TOKENS.emplace_back(Token::Type::Keyword, startPoint, point, tokenText);
+		LINE_TOKENS.emplace_back(Token::Type::Keyword, startPoint, point, std::string(tokenText));
 	}
 	else if (tokenText == "defined")
 	{
@@ -678,7 +867,7 @@ bool Lexer::lexKeyword(const Point& startPoint, const Point& point, const std::s
 
 		if (foundIfElifDirectiveOnLine)
 		{
-			LINE_TOKENS.emplace_back(Token::Type::PreprocessorDirective, startPoint, point, tokenText);
+			LINE_TOKENS.emplace_back(Token::Type::PreprocessorDirective, startPoint, point, std::string(tokenText));
 		}
 		else
 		{
@@ -693,7 +882,7 @@ bool Lexer::lexKeyword(const Point& startPoint, const Point& point, const std::s
 	return true;
 }
 
-void Lexer::lexIdentifier(const Point& startPoint, const Point& point, const std::string& tokenText)
+void Lexer::lexIdentifier(const Point& startPoint, const Point& point, KeywordType keywordType)
 {
 	const Token* lastToken = LINE_STATE.getTokenBefore(LINE_TOKENS.size(), EXCLUDE_COMMENT);
 
@@ -703,7 +892,7 @@ void Lexer::lexIdentifier(const Point& startPoint, const Point& point, const std
 	{
 		LINE_TOKENS.emplace_back(Token::Type::MacroName, startPoint, point);
 	}
-	else if (primitiveTypes.find(tokenText) != primitiveTypes.end())
+	else if (keywordType == KeywordType::PrimitiveType)
 	{
 		LINE_TOKENS.emplace_back(Token::Type::TypeName, startPoint, point);
 	}
@@ -1049,11 +1238,13 @@ bool Lexer::lexPunctuation(Point& point)
 	return true;
 }
 
-void Lexer::doFinalAdjustments()
+void Lexer::doFinalAdjustments(unsigned int firstLine, unsigned int lastLine)
 {
 	// TODO(fkp): Use semicolons instead of lines
-	for (LineLexState& lineState : lineStates)
+	for (unsigned int line = firstLine; line <= lastLine && line < lineStates.size(); line++)
 	{
+		LineLexState& lineState = lineStates[line];
+
 		for (int i = 0; i < lineState.tokens.size(); i++)
 		{
 			if (lineState.tokens[i].type == Token::Type::ScopeResolution)
@@ -1082,8 +1273,9 @@ void Lexer::doFinalAdjustments()
 					{
 						Token* tokenBeforeLast = lineState.getTokenBefore(i - 1, EXCLUDE_COMMENT | EXCLUDE_ASTERISK | EXCLUDE_AMPERSAND | EXCLUDE_SCOPE_RESOLUTION | EXCLUDE_TYPE_BEFORE_SCOPE);
 						
-						if (tokenBeforeLast->type == Token::Type::IdentifierUsage ||
-							tokenBeforeLast->type == Token::Type::TypeName)
+						if (tokenBeforeLast &&
+							(tokenBeforeLast->type == Token::Type::IdentifierUsage ||
+							 tokenBeforeLast->type == Token::Type::TypeName))
 						{
 							lastToken->type = Token::Type::FunctionDefinition;
 							tokenBeforeLast->type = Token::Type::TypeName;
@@ -1139,9 +1331,111 @@ void Lexer::doFinalAdjustments()
 			}
 		}
 	}
+}
+
+// Whether a function signature could carry on past the end of the line
+static bool endsStatement(LineLexState& lineState)
+{
+	Token* lastToken = lineState.getTokenBefore((int) lineState.tokens.size(), EXCLUDE_COMMENT);
 
-	// TODO(fkp): Move this somewhere else
-	buffer->functionDefinitions = findFunctionsInBuffer();
+	return lastToken &&
+		   (lastToken->type == Token::Type::Semicolon ||
+			lastToken->type == Token::Type::LeftBrace ||
+			lastToken->type == Token::Type::RightBrace);
+}
+
+void Lexer::updateFunctionDefinitions(unsigned int firstLine, unsigned int lastLine)
+{
+	if (lineStates.size() == 0 || lineStates.size() != buffer->data.size())
+	{
+		printf("Error: Buffer not lexed, cannot find functions.\n");
+		return;
+	}
+
+	// NOTE(fkp): A signature can be spread over several lines, so this
+	// goes out to the ends of the statements around the lexed lines.
+	// Those are usually close by, so this doesn't depend on the size
+	// of the file.
+	lastLine = std::min<unsigned int>(lastLine, (unsigned int) lineStates.size() - 1);
+
+	while (firstLine > 0 && !endsStatement(lineStates[firstLine - 1]))
+	{
+		firstLine -= 1;
+	}
+
+	while (lastLine < lineStates.size() - 1 && !endsStatement(lineStates[lastLine]))
+	{
+		lastLine += 1;
+	}
+
+	for (unsigned int line = firstLine; line <= lastLine; line++)
+	{
+		removeFunctionDefinitions(lineStates[line]);
+	}
+
+	findFunctionsInLines(firstLine, lastLine);
+
+	for (unsigned int line = firstLine; line <= lastLine; line++)
+	{
+		addFunctionDefinitions(lineStates[line]);
+	}
+}
+
+void Lexer::addFunctionDefinitions(LineLexState& lineState)
+{
+	for (const std::pair<std::string, std::string>& function : lineState.functionDefinitions)
+	{
+		std::vector<std::string>& signatures = functionSignatures[function.first];
+		signatures.push_back(function.second);
+
+		if (signatures.size() == 1)
+		{
+			buffer->functionDefinitions[function.first] = function.second;
+		}
+	}
+}
+
+void Lexer::removeFunctionDefinitions(LineLexState& lineState)
+{
+	for (const std::pair<std::string, std::string>& function : lineState.functionDefinitions)
+	{
+		auto signatures = functionSignatures.find(function.first);
+
+		if (signatures == functionSignatures.end())
+		{
+			continue;
+		}
+
+		auto signature = std::find(signatures->second.begin(), signatures->second.end(), function.second);
+
+		if (signature != signatures->second.end())
+		{
+			signatures->second.erase(signature);
+		}
+
+		if (signatures->second.size() == 0)
+		{
+			functionSignatures.erase(signatures);
+			buffer->functionDefinitions.erase(function.first);
+		}
+		else
+		{
+			buffer->functionDefinitions[function.first] = signatures->second.front();
+		}
+	}
+
+	lineState.functionDefinitions.clear();
+}
+
+void Lexer::clearFunctionDefinitions()
+{
+	for (LineLexState& lineState : lineStates)
+	{
+		lineState.functionDefinitions.clear();
+	}
+
+	functionSignatures.clear();
+	buffer->functionDefinitions.clear();
 }
 
 bool Lexer::isIdentifierStartCharacter(char character)
@@ -1168,17 +1462,9 @@ bool Lexer::isValidHexDigit(char character)
 	return number || lowercaseHex || uppercaseHex;
 }
 
-std::unordered_map<std::string, std::string> Lexer::findFunctionsInBuffer()
+void Lexer::findFunctionsInLines(unsigned int firstLine, unsigned int lastLine)
 {
-	std::unordered_map<std::string, std::string> result;
-	
-	if (lineStates.size() == 0 || lineStates.size() != buffer->data.size())
-	{
-		printf("Error: Buffer not lexed, cannot find functions.\n");
-		return result;
-	}
-
-	std::vector<Token*> tokens = getTokens(0, lineStates.size() - 1);
+	std::vector<Token*> tokens = getTokens(firstLine, lastLine);
 	
 	for (int i = 0; i < tokens.size(); i++)
 	{
@@ -1247,10 +1533,8 @@ std::unordered_map<std::string, std::string> Lexer::findFunctionsInBuffer()
 				}
 			}
 
-			result.emplace(buffer->substrFromPoints(token.start, token.end), functionSignature);
+			lineStates[token.start.line].functionDefinitions.emplace_back(buffer->substrFromPoints(token.start, token.end), functionSignature);
 			i = endIndex;
 		}
 	}
-
-	return result;
 }
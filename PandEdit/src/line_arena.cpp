@@ -0,0 +1,123 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include "line_arena.hpp"
+
+unsigned char LineArena::getSizeClass(std::size_t size)
+{
+	unsigned char sizeClass = 0;
+
+	while (getBlockSize(sizeClass) < size)
+	{
+		sizeClass += 1;
+	}
+
+	return sizeClass;
+}
+
+std::size_t LineArena::getBlockSize(unsigned char sizeClass)
+{
+	return MIN_BLOCK_SIZE << sizeClass;
+}
+
+std::size_t LineArena::allocate(unsigned char sizeClass)
+{
+	std::size_t blockSize = getBlockSize(sizeClass);
+
+	if (sizeClass >= freeBlocks.size())
+	{
+		freeBlocks.resize(sizeClass + 1);
+	}
+
+	numberOfBytesInUse += blockSize;
+
+	if (freeBlocks[sizeClass].size() > 0)
+	{
+		std::size_t block = freeBlocks[sizeClass].back();
+		freeBlocks[sizeClass].pop_back();
+		numberOfBytesFree -= blockSize;
+
+		return block;
+	}
+
+	// NOTE(fkp): A block is the slab index times SLAB_SIZE plus the
+	// offset in the slab. Large blocks are always at offset 0.
+	if (sizeClass >= FIRST_LARGE_SIZE_CLASS)
+	{
+		std::size_t slab;
+
+		if (freeSlabs.size() > 0)
+		{
+			slab = freeSlabs.back();
+			freeSlabs.pop_back();
+		}
+		else
+		{
+			slab = slabs.size();
+			slabs.emplace_back();
+		}
+
+		slabs[slab].reset(new char[blockSize]);
+		numberOfHeapAllocations += 1;
+		numberOfBytesReserved += blockSize;
+
+		return slab * SLAB_SIZE;
+	}
+
+	if (currentSlabUsed + blockSize > SLAB_SIZE)
+	{
+		// The rest of the old slab is left unused, it is less than the
+		// largest small block.
+		currentSlab = slabs.size();
+		currentSlabUsed = 0;
+		slabs.emplace_back(new char[SLAB_SIZE]);
+		numberOfHeapAllocations += 1;
+		numberOfBytesReserved += SLAB_SIZE;
+	}
+
+	std::size_t block = currentSlab * SLAB_SIZE + currentSlabUsed;
+	currentSlabUsed += blockSize;
+
+	return block;
+}
+
+void LineArena::free(std::size_t block, unsigned char sizeClass)
+{
+	std::size_t blockSize = getBlockSize(sizeClass);
+	numberOfBytesInUse -= blockSize;
+
+	if (sizeClass >= FIRST_LARGE_SIZE_CLASS)
+	{
+		// Large blocks are given back straight away
+		std::size_t slab = block / SLAB_SIZE;
+		slabs[slab].reset();
+		freeSlabs.push_back(slab);
+		numberOfBytesReserved -= blockSize;
+
+		return;
+	}
+
+	freeBlocks[sizeClass].push_back(block);
+	numberOfBytesFree += blockSize;
+}
+
+char* LineArena::getData(std::size_t block)
+{
+	return slabs[block / SLAB_SIZE].get() + block % SLAB_SIZE;
+}
+
+const char* LineArena::getData(std::size_t block) const
+{
+	return slabs[block / SLAB_SIZE].get() + block % SLAB_SIZE;
+}
+
+void LineArena::clear()
+{
+	slabs.clear();
+	freeSlabs.clear();
+	freeBlocks.clear();
+	currentSlab = (std::size_t) -1;
+	currentSlabUsed = SLAB_SIZE;
+	numberOfBytesInUse = 0;
+	numberOfBytesFree = 0;
+	numberOfBytesReserved = 0;
+}
@@ -17,6 +17,7 @@
 #include "default_key_bindings.hpp"
 #include "timer.hpp"
 #include "colour.hpp"
+#include "buffer.hpp"
 
 int main(int argc, char* argv[])
 {
@@ -54,6 +55,12 @@ int main(int argc, char* argv[])
 			DispatchMessage(&message);
 		}
 
+		// Loading, saving and the like happen between frames
+		for (std::pair<const std::string, Buffer*>& pair : Buffer::buffersMap)
+		{
+			pair.second->update();
+		}
+
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		window.draw();
 
@@ -0,0 +1,105 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <bitset>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NEWLINE_SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NEWLINE_SCAN_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "newline_scan.hpp"
+
+static unsigned int countTrailingZeros(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+const char* findNewline(const char* start, const char* end)
+{
+	const char* current = start;
+
+#if defined(NEWLINE_SCAN_AVX2)
+	const __m256i newlines = _mm256_set1_epi8('\n');
+
+	for (; end - current >= 32; current += 32)
+	{
+		__m256i block = _mm256_loadu_si256((const __m256i*) current);
+		unsigned int mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newlines));
+
+		if (mask != 0)
+		{
+			return current + countTrailingZeros(mask);
+		}
+	}
+#elif defined(NEWLINE_SCAN_SSE2)
+	const __m128i newlines = _mm_set1_epi8('\n');
+
+	for (; end - current >= 16; current += 16)
+	{
+		__m128i block = _mm_loadu_si128((const __m128i*) current);
+		unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(block, newlines));
+
+		if (mask != 0)
+		{
+			return current + countTrailingZeros(mask);
+		}
+	}
+#endif
+
+	// The tail (or everything without SIMD)
+	if (current == end)
+	{
+		return end;
+	}
+
+	const char* newline = (const char*) memchr(current, '\n', end - current);
+	return newline ? newline : end;
+}
+
+std::size_t countNewlines(const char* start, const char* end)
+{
+	std::size_t count = 0;
+	const char* current = start;
+
+#if defined(NEWLINE_SCAN_AVX2)
+	const __m256i newlines = _mm256_set1_epi8('\n');
+
+	for (; end - current >= 32; current += 32)
+	{
+		__m256i block = _mm256_loadu_si256((const __m256i*) current);
+		count += std::bitset<32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newlines))).count();
+	}
+#elif defined(NEWLINE_SCAN_SSE2)
+	const __m128i newlines = _mm_set1_epi8('\n');
+
+	for (; end - current >= 16; current += 16)
+	{
+		__m128i block = _mm_loadu_si128((const __m128i*) current);
+		count += std::bitset<32>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newlines))).count();
+	}
+#endif
+
+	for (; current < end; current++)
+	{
+		if (*current == '\n')
+		{
+			count += 1;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,367 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+#include <functional>
+#include <stdio.h>
+
+#include "paged_file.hpp"
+#include "newline_scan.hpp"
+
+PagedFile::~PagedFile()
+{
+	close();
+}
+
+bool PagedFile::open(const std::string& filePath)
+{
+	close();
+
+	path = filePath;
+	file.open(path, std::ios::binary);
+
+	if (!file)
+	{
+		printf("Error: Failed to open file '%s' for paging.\n", path.c_str());
+		return false;
+	}
+
+	file.seekg(0, std::ios::end);
+	fileSize = (std::uint64_t) file.tellg();
+
+	if (fileSize > 0)
+	{
+		char lastCharacter;
+		readAt(file, fileSize - 1, &lastCharacter, 1);
+		doesEndWithNewline = lastCharacter == '\n';
+	}
+
+	checkpoints = { 0 };
+	numberOfBytesIndexed = 0;
+	numberOfNewlines = 0;
+	isIndexingDone = false;
+	shouldStopIndexing = false;
+	indexThread = std::thread(&PagedFile::buildIndex, this);
+
+	return true;
+}
+
+void PagedFile::close()
+{
+	shouldStopIndexing = true;
+
+	if (indexThread.joinable())
+	{
+		indexThread.join();
+	}
+
+	if (file.is_open())
+	{
+		file.close();
+	}
+
+	fileSize = 0;
+	checkpoints.clear();
+	std::vector<char>().swap(readBuffer);
+}
+
+bool PagedFile::isIndexComplete() const
+{
+	return isIndexingDone;
+}
+
+double PagedFile::getIndexProgress() const
+{
+	if (fileSize == 0)
+	{
+		return 1.0;
+	}
+
+	return (double) numberOfBytesIndexed / (double) fileSize;
+}
+
+std::uint64_t PagedFile::getNumberOfLines() const
+{
+	// NOTE(fkp): A loaded buffer always ends with an empty line (see
+	// readFile()), so a last line without a newline adds one more.
+	if (fileSize == 0)
+	{
+		return 1;
+	}
+
+	return numberOfNewlines + (doesEndWithNewline ? 1 : 2);
+}
+
+std::string PagedFile::readLines(std::uint64_t startOffset, unsigned int maxNumberOfLines, std::vector<std::uint64_t>& lineOffsets, std::uint64_t& endOffset)
+{
+	std::string text;
+	char* chunk = getReadBuffer(CHUNK_SIZE);
+	std::uint64_t chunkOffset = startOffset;
+	std::uint64_t lineStart = startOffset;
+
+	lineOffsets.clear();
+
+	while (chunkOffset < fileSize && lineOffsets.size() < maxNumberOfLines)
+	{
+		std::size_t numberRead = readAt(file, chunkOffset, chunk, CHUNK_SIZE);
+		if (numberRead == 0) break;
+
+		const char* start = chunk;
+		const char* end = start + numberRead;
+		const char* current = start;
+
+		while (current < end && lineOffsets.size() < maxNumberOfLines)
+		{
+			const char* newline = findNewline(current, end);
+
+			if (newline == end)
+			{
+				// The line carries on into the next chunk
+				text.append(current, end - current);
+				current = end;
+				break;
+			}
+
+			text.append(current, newline + 1 - current);
+			lineOffsets.push_back(lineStart);
+			lineStart = chunkOffset + (newline + 1 - start);
+			current = newline + 1;
+		}
+
+		chunkOffset += current - start;
+	}
+
+	if (lineOffsets.size() < maxNumberOfLines && lineStart < fileSize)
+	{
+		// The last line of the file has no newline
+		lineOffsets.push_back(lineStart);
+		lineStart = fileSize;
+	}
+
+	text.resize(lineStart - startOffset);
+	endOffset = lineStart;
+
+	return text;
+}
+
+unsigned int PagedFile::findStartOfPreviousLines(std::uint64_t lineStartOffset, unsigned int numberOfLines, std::uint64_t& startOffset)
+{
+	startOffset = lineStartOffset;
+
+	if (lineStartOffset == 0 || numberOfLines == 0)
+	{
+		return 0;
+	}
+
+	unsigned int numberOfLinesPassed = 0;
+	char* chunk = getReadBuffer(CHUNK_SIZE);
+
+	// Skips the newline that ends the previous line
+	std::uint64_t chunkEnd = lineStartOffset - 1;
+
+	while (chunkEnd > 0)
+	{
+		std::uint64_t chunkStart = chunkEnd > CHUNK_SIZE ? chunkEnd - CHUNK_SIZE : 0;
+		std::size_t numberRead = readAt(file, chunkStart, chunk, (std::size_t) (chunkEnd - chunkStart));
+
+		for (std::size_t i = numberRead; i > 0; i--)
+		{
+			if (chunk[i - 1] == '\n')
+			{
+				numberOfLinesPassed += 1;
+
+				if (numberOfLinesPassed == numberOfLines)
+				{
+					startOffset = chunkStart + i;
+					return numberOfLinesPassed;
+				}
+			}
+		}
+
+		chunkEnd = chunkStart;
+	}
+
+	// Reached the first line of the file
+	startOffset = 0;
+	return numberOfLinesPassed + 1;
+}
+
+// The start of the line that position is on, if the window doesn't have
+// a newline before it that's the line the window itself starts on.
+static std::uint64_t findLineStartInWindow(const char* start, const char* position, std::uint64_t windowOffset, std::uint64_t windowLineStartOffset)
+{
+	for (const char* current = position; current > start; current--)
+	{
+		if (current[-1] == '\n')
+		{
+			return windowOffset + (current - start);
+		}
+	}
+
+	return windowLineStartOffset;
+}
+
+bool PagedFile::find(std::uint64_t startOffset, const std::string& text, std::uint64_t& foundOffset, std::uint64_t& lineStartOffset, std::uint64_t& numberOfNewlinesPassed)
+{
+	if (text.size() == 0 || text.size() > CHUNK_SIZE)
+	{
+		return false;
+	}
+
+	// Each window keeps the end of the last one, so matches that cross
+	// chunks are still found.
+	std::size_t overlap = text.size() - 1;
+	char* window = getReadBuffer(overlap + CHUNK_SIZE);
+	std::size_t carrySize = 0;
+	std::uint64_t windowOffset = startOffset;
+	// The start of the line the window starts on
+	std::uint64_t windowLineStartOffset = lineStartOffset;
+	std::boyer_moore_horspool_searcher searcher(text.begin(), text.end());
+
+	numberOfNewlinesPassed = 0;
+
+	while (windowOffset + carrySize < fileSize)
+	{
+		std::size_t numberRead = readAt(file, windowOffset + carrySize, window + carrySize, CHUNK_SIZE);
+		if (numberRead == 0) break;
+
+		const char* start = window;
+		const char* newStart = start + carrySize;
+		const char* end = newStart + numberRead;
+		const char* match = std::search(start, end, searcher);
+
+		if (match != end)
+		{
+			// Newlines in the carried over part were already counted
+			if (match >= newStart)
+			{
+				numberOfNewlinesPassed += countNewlines(newStart, match);
+			}
+			else
+			{
+				numberOfNewlinesPassed -= countNewlines(match, newStart);
+			}
+
+			foundOffset = windowOffset + (match - start);
+			lineStartOffset = findLineStartInWindow(start, match, windowOffset, windowLineStartOffset);
+
+			return true;
+		}
+
+		numberOfNewlinesPassed += countNewlines(newStart, end);
+
+		// Moves the end of this window to the start of the next one
+		std::size_t numberToCarry = std::min<std::size_t>(overlap, end - start);
+		windowLineStartOffset = findLineStartInWindow(start, end - numberToCarry, windowOffset, windowLineStartOffset);
+		std::copy(end - numberToCarry, end, window);
+		windowOffset += (end - start) - numberToCarry;
+		carrySize = numberToCarry;
+	}
+
+	return false;
+}
+
+bool PagedFile::getLineAtOffset(std::uint64_t lineStartOffset, std::uint64_t& line)
+{
+	if (!isIndexingDone && lineStartOffset >= numberOfBytesIndexed)
+	{
+		return false;
+	}
+
+	std::uint64_t checkpointOffset;
+	std::size_t checkpointIndex;
+
+	{
+		std::lock_guard<std::mutex> lock { checkpointsMutex };
+		auto checkpoint = std::upper_bound(checkpoints.begin(), checkpoints.end(), lineStartOffset) - 1;
+		checkpointOffset = *checkpoint;
+		checkpointIndex = checkpoint - checkpoints.begin();
+	}
+
+	// There are at most LINES_PER_CHECKPOINT lines to count
+	line = (std::uint64_t) checkpointIndex * LINES_PER_CHECKPOINT;
+	char* chunk = getReadBuffer(CHUNK_SIZE);
+
+	while (checkpointOffset < lineStartOffset)
+	{
+		std::size_t sizeToRead = (std::size_t) std::min<std::uint64_t>(CHUNK_SIZE, lineStartOffset - checkpointOffset);
+		std::size_t numberRead = readAt(file, checkpointOffset, chunk, sizeToRead);
+		if (numberRead == 0) break;
+
+		line += countNewlines(chunk, chunk + numberRead);
+		checkpointOffset += numberRead;
+	}
+
+	return true;
+}
+
+// NOTE(fkp): This runs on its own thread with its own stream
+void PagedFile::buildIndex()
+{
+	std::ifstream indexFile(path, std::ios::binary);
+
+	if (!indexFile)
+	{
+		printf("Error: Failed to open file '%s' for indexing.\n", path.c_str());
+		return;
+	}
+
+	std::vector<char> chunk(CHUNK_SIZE);
+	std::uint64_t chunkOffset = 0;
+	std::uint64_t lineCount = 0;
+	std::uint64_t nextCheckpointLine = LINES_PER_CHECKPOINT;
+
+	while (chunkOffset < fileSize && !shouldStopIndexing)
+	{
+		std::size_t numberRead = readAt(indexFile, chunkOffset, chunk.data(), chunk.size());
+		if (numberRead == 0) break;
+
+		const char* start = chunk.data();
+		const char* end = start + numberRead;
+		std::size_t numberOfNewlinesInChunk = countNewlines(start, end);
+
+		if (lineCount + numberOfNewlinesInChunk < nextCheckpointLine)
+		{
+			// No checkpoints in this chunk
+			lineCount += numberOfNewlinesInChunk;
+		}
+		else
+		{
+			for (const char* current = findNewline(start, end); current != end; current = findNewline(current + 1, end))
+			{
+				lineCount += 1;
+
+				if (lineCount == nextCheckpointLine)
+				{
+					std::lock_guard<std::mutex> lock { checkpointsMutex };
+					checkpoints.push_back(chunkOffset + (current + 1 - start));
+					nextCheckpointLine += LINES_PER_CHECKPOINT;
+				}
+			}
+		}
+
+		chunkOffset += numberRead;
+		numberOfNewlines = lineCount;
+		numberOfBytesIndexed = chunkOffset;
+	}
+
+	isIndexingDone = !shouldStopIndexing;
+}
+
+std::size_t PagedFile::readAt(std::ifstream& stream, std::uint64_t offset, char* destination, std::size_t size)
+{
+	stream.clear();
+	stream.seekg((std::streamoff) offset);
+	stream.read(destination, size);
+
+	return (std::size_t) stream.gcount();
+}
+
+char* PagedFile::getReadBuffer(std::size_t size)
+{
+	if (readBuffer.size() < size)
+	{
+		readBuffer.resize(size);
+	}
+
+	return readBuffer.data();
+}
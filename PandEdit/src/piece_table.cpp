@@ -0,0 +1,887 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+#include "piece_table.hpp"
+#include "newline_scan.hpp"
+#include "common.hpp"
+
+void PieceTable::loadFromString(std::string&& contents)
+{
+	clear();
+	original = std::move(contents);
+	buildLines(false);
+}
+
+void PieceTable::loadFromMapping(FileMapping&& fileMapping)
+{
+	clear();
+	mapping = std::move(fileMapping);
+
+	// NOTE(fkp): readFile() makes sure the contents end with a newline,
+	// this has to add the empty last line itself to match it.
+	buildLines(mapping.size() > 0 && mapping.data()[mapping.size() - 1] != '\n');
+}
+
+void PieceTable::buildLines(bool addEmptyLastLine)
+{
+	// Only one allocation is needed for all the pieces
+	const char* data = getOriginalData();
+	std::size_t originalSize = getOriginalSize();
+	std::size_t numberOfLines = countNewlines(data, data + originalSize) + 2;
+	std::vector<int> lineNodes;
+
+	nodes.reserve(numberOfLines);
+	lineNodes.reserve(numberOfLines);
+	allocateLines(0, originalSize, lineNodes);
+
+	if (addEmptyLastLine)
+	{
+		lineNodes.push_back(allocateNode(Piece {}));
+	}
+
+	root = buildTree(lineNodes);
+}
+
+void PieceTable::insertLines(unsigned int line, std::string_view text)
+{
+	if (text.size() == 0 || mapping.isOpen())
+	{
+		return;
+	}
+
+	if (line > size())
+	{
+		line = size();
+	}
+
+	// NOTE(fkp): The text is treated as more of the original file, this
+	// is only used while the file is still being loaded.
+	std::size_t start = original.size();
+	original.append(text);
+
+	std::vector<int> lineNodes;
+	lineNodes.reserve(countNewlines(text.data(), text.data() + text.size()) + 1);
+
+	// The last newline ends the last line, it doesn't start a new one
+	std::size_t end = original.size();
+	if (original[end - 1] == '\n') end -= 1;
+	allocateLines(start, end, lineNodes);
+
+	int left;
+	int right;
+	split(root, line, left, right);
+	root = merge(merge(left, buildTree(lineNodes)), right);
+
+	invalidateCache();
+}
+
+void PieceTable::allocateLines(std::size_t start, std::size_t end, std::vector<int>& lineNodes)
+{
+	const char* data = getOriginalData();
+	std::size_t lineStart = start;
+
+	while (true)
+	{
+		const char* newline = findNewline(data + lineStart, data + end);
+		std::size_t lineEnd = newline - data;
+		std::size_t length = lineEnd - lineStart;
+
+		if (length > 0 && data[lineEnd - 1] == '\r')
+		{
+			length -= 1;
+		}
+
+		lineNodes.push_back(allocateNode(Piece { Source::Original, 0, lineStart, length }));
+
+		if (lineEnd == end)
+		{
+			break;
+		}
+
+		lineStart = lineEnd + 1;
+	}
+}
+
+int PieceTable::buildTree(const std::vector<int>& lineNodes)
+{
+	// Builds the treap in linear time. The nodes are already in order,
+	// so this is just building a cartesian tree on the priorities.
+	std::vector<int> stack;
+	int treeRoot = -1;
+
+	for (int node : lineNodes)
+	{
+		int lastPopped = -1;
+
+		while (!stack.empty() && nodes[stack.back()].priority < nodes[node].priority)
+		{
+			lastPopped = stack.back();
+			stack.pop_back();
+			update(lastPopped);
+		}
+
+		nodes[node].left = lastPopped;
+
+		if (!stack.empty())
+		{
+			nodes[stack.back()].right = node;
+		}
+
+		stack.push_back(node);
+	}
+
+	while (!stack.empty())
+	{
+		update(stack.back());
+		treeRoot = stack.back();
+		stack.pop_back();
+	}
+
+	return treeRoot;
+}
+
+void PieceTable::clear()
+{
+	original = std::string();
+	mapping.close();
+	arena.clear();
+	nodes.clear();
+	freeNodes.clear();
+	root = -1;
+
+	invalidateCache();
+}
+
+bool PieceTable::isMapped() const
+{
+	return mapping.isOpen();
+}
+
+void PieceTable::detachFromMapping()
+{
+	if (!mapping.isOpen())
+	{
+		return;
+	}
+
+	// The pieces keep the same offsets into the copy
+	original.assign(mapping.data(), mapping.size());
+	mapping.close();
+}
+
+unsigned int PieceTable::size() const
+{
+	return getNumberOfLines(root);
+}
+
+std::size_t PieceTable::getNumberOfChars() const
+{
+	// There is no newline after the last line
+	std::size_t numberOfChars = getNumberOfChars(root);
+	return numberOfChars > 0 ? numberOfChars - 1 : 0;
+}
+
+std::size_t PieceTable::getOffsetOfLine(unsigned int line) const
+{
+	std::size_t offset = 0;
+	int node = root;
+	unsigned int lineToFind = line;
+
+	while (node != -1)
+	{
+		unsigned int numberOfLinesLeft = getNumberOfLines(nodes[node].left);
+
+		if (lineToFind < numberOfLinesLeft)
+		{
+			node = nodes[node].left;
+		}
+		else
+		{
+			offset += getNumberOfChars(nodes[node].left);
+
+			if (lineToFind == numberOfLinesLeft)
+			{
+				return offset;
+			}
+
+			offset += nodes[node].piece.length + 1;
+			lineToFind -= numberOfLinesLeft + 1;
+			node = nodes[node].right;
+		}
+	}
+
+	// Past the end, gives the offset the line would start at
+	return getNumberOfChars(root);
+}
+
+// Finds the line containing the offset. The newline at the end of a
+// line counts as part of that line.
+unsigned int PieceTable::getLineAtOffset(std::size_t offset, std::size_t& lineStartOffset) const
+{
+	unsigned int line = 0;
+	lineStartOffset = 0;
+	int node = root;
+
+	while (node != -1)
+	{
+		std::size_t numberOfCharsLeft = getNumberOfChars(nodes[node].left);
+		std::size_t lineLength = nodes[node].piece.length + 1;
+
+		if (offset < numberOfCharsLeft)
+		{
+			node = nodes[node].left;
+		}
+		else if (offset < numberOfCharsLeft + lineLength || nodes[node].right == -1)
+		{
+			line += getNumberOfLines(nodes[node].left);
+			lineStartOffset += numberOfCharsLeft;
+
+			return line;
+		}
+		else
+		{
+			offset -= numberOfCharsLeft + lineLength;
+			line += getNumberOfLines(nodes[node].left) + 1;
+			lineStartOffset += numberOfCharsLeft + lineLength;
+			node = nodes[node].right;
+		}
+	}
+
+	return line;
+}
+
+LineView PieceTable::operator[](unsigned int line) const
+{
+	int node = findNode(line);
+
+	if (node == -1)
+	{
+		ERROR_ONCE("Error: Line %u is not in the piece table.\n", line);
+		return LineView {};
+	}
+
+	const Piece& piece = nodes[node].piece;
+	return LineView { getPieceData(piece), piece.length };
+}
+
+void PieceTable::insertLine(unsigned int line, std::string_view text)
+{
+	if (line > size())
+	{
+		line = size();
+	}
+
+	int newNode = allocateNode(makePiece(text));
+	int left;
+	int right;
+	split(root, line, left, right);
+	root = merge(merge(left, newNode), right);
+
+	invalidateCache();
+}
+
+void PieceTable::appendLine(std::string_view text)
+{
+	insertLine(size(), text);
+}
+
+void PieceTable::eraseLine(unsigned int line)
+{
+	if (line >= size())
+	{
+		return;
+	}
+
+	int left;
+	int middle;
+	int right;
+	split(root, line, left, right);
+	split(right, 1, middle, right);
+	freeNode(middle);
+	root = merge(left, right);
+
+	numberOfEdits += 1;
+	invalidateCache();
+}
+
+void PieceTable::spliceLines(unsigned int line, std::string_view text)
+{
+	if (line > size())
+	{
+		line = size();
+	}
+
+	std::vector<int> lineNodes;
+	lineNodes.reserve(countNewlines(text.data(), text.data() + text.size()) + 1);
+	std::size_t lineStart = 0;
+
+	while (true)
+	{
+		std::size_t newline = text.find('\n', lineStart);
+		lineNodes.push_back(allocateNode(makePiece(text.substr(lineStart, newline - lineStart))));
+
+		if (newline == std::string_view::npos) break;
+		lineStart = newline + 1;
+	}
+
+	int left;
+	int right;
+	split(root, line, left, right);
+	root = merge(merge(left, buildTree(lineNodes)), right);
+
+	numberOfEdits += 1;
+	invalidateCache();
+}
+
+void PieceTable::eraseLines(unsigned int line, unsigned int count)
+{
+	if (line >= size() || count == 0)
+	{
+		return;
+	}
+
+	int left;
+	int middle;
+	int right;
+	split(root, line, left, right);
+	split(right, count, middle, right);
+	root = merge(left, right);
+
+	forEachNode(middle, [&](int node)
+	{
+		freeNode(node);
+	});
+
+	numberOfEdits += 1;
+	invalidateCache();
+}
+
+void PieceTable::setLine(unsigned int line, std::string_view text)
+{
+	int node = findNode(line);
+	if (node == -1) return;
+
+	Piece& piece = nodes[node].piece;
+	std::ptrdiff_t change = (std::ptrdiff_t) text.size() - (std::ptrdiff_t) piece.length;
+
+	if (piece.source == Source::Added && LineArena::getBlockSize(piece.sizeClass) >= text.size())
+	{
+		// The text may be part of this line, so it can overlap
+		memmove(arena.getData(piece.start), text.data(), text.size());
+	}
+	else
+	{
+		// NOTE(fkp): The old block is freed after the copy, in case the
+		// text is part of it.
+		Piece oldPiece = piece;
+		piece = makePiece(text);
+
+		if (oldPiece.source == Source::Added)
+		{
+			arena.free(oldPiece.start, oldPiece.sizeClass);
+		}
+	}
+
+	piece.length = text.size();
+	changeLineLength(line, change);
+	numberOfEdits += 1;
+}
+
+void PieceTable::insertText(unsigned int line, unsigned int col, std::string_view text)
+{
+	if (text.size() == 0)
+	{
+		return;
+	}
+
+	int node = findNode(line);
+	if (node == -1) return;
+
+	// Growing the line would free the block the text is in
+	if (isInBlock(nodes[node].piece, text.data()))
+	{
+		std::string copy { text };
+		insertText(line, col, copy);
+		return;
+	}
+
+	Piece& piece = makeLineWritable(line, nodes[node].piece.length + text.size());
+	if (col > piece.length) col = (unsigned int) piece.length;
+
+	char* data = arena.getData(piece.start);
+	memmove(data + col + text.size(), data + col, piece.length - col);
+	memcpy(data + col, text.data(), text.size());
+	piece.length += text.size();
+	changeLineLength(line, text.size());
+	numberOfEdits += 1;
+}
+
+void PieceTable::insertChar(unsigned int line, unsigned int col, char character)
+{
+	insertText(line, col, std::string_view { &character, 1 });
+}
+
+void PieceTable::overwriteChar(unsigned int line, unsigned int col, char character)
+{
+	int node = findNode(line);
+	if (node == -1 || col >= nodes[node].piece.length) return;
+
+	Piece& piece = makeLineWritable(line, nodes[node].piece.length);
+	arena.getData(piece.start)[col] = character;
+	numberOfEdits += 1;
+}
+
+void PieceTable::eraseText(unsigned int line, unsigned int col, unsigned int count)
+{
+	int node = findNode(line);
+	if (node == -1) return;
+
+	Piece& piece = nodes[node].piece;
+	if (col >= piece.length) return;
+	if (count > piece.length - col) count = (unsigned int) (piece.length - col);
+
+	// Removing from the end doesn't need to touch the text, and neither
+	// does removing from the start of original text.
+	if (col + count == piece.length)
+	{
+		piece.length -= count;
+	}
+	else if (col == 0 && piece.source == Source::Original)
+	{
+		piece.start += count;
+		piece.length -= count;
+	}
+	else
+	{
+		Piece& writablePiece = makeLineWritable(line, piece.length);
+		char* data = arena.getData(writablePiece.start);
+		memmove(data + col, data + col + count, writablePiece.length - col - count);
+		writablePiece.length -= count;
+	}
+
+	changeLineLength(line, -(std::ptrdiff_t) count);
+	numberOfEdits += 1;
+}
+
+void PieceTable::splitLine(unsigned int line, unsigned int col)
+{
+	int node = findNode(line);
+	if (node == -1) return;
+
+	Piece& piece = nodes[node].piece;
+	if (col > piece.length) col = (unsigned int) piece.length;
+
+	// Original text can be shared, but each line has its own block
+	Piece restOfLine { piece.source, 0, piece.start + col, piece.length - col };
+
+	if (piece.source == Source::Added)
+	{
+		restOfLine = makePiece(std::string_view { arena.getData(piece.start) + col, piece.length - col });
+	}
+
+	Piece& shortenedPiece = nodes[node].piece;
+	shortenedPiece.length = col;
+	changeLineLength(line, -(std::ptrdiff_t) restOfLine.length);
+
+	int newNode = allocateNode(restOfLine);
+	int left;
+	int right;
+	split(root, line + 1, left, right);
+	root = merge(merge(left, newNode), right);
+
+	numberOfEdits += 1;
+	invalidateCache();
+}
+
+void PieceTable::joinLines(unsigned int line)
+{
+	if (line + 1 >= size())
+	{
+		return;
+	}
+
+	Piece nextPiece = nodes[findNode(line + 1)].piece;
+
+	if (nextPiece.length > 0)
+	{
+		std::size_t length = nodes[findNode(line)].piece.length;
+		Piece& piece = makeLineWritable(line, length + nextPiece.length);
+
+		memcpy(arena.getData(piece.start) + length, getPieceData(nextPiece), nextPiece.length);
+		piece.length += nextPiece.length;
+		changeLineLength(line, nextPiece.length);
+	}
+
+	eraseLine(line + 1);
+}
+
+const char* PieceTable::getOriginalData() const
+{
+	return mapping.isOpen() ? mapping.data() : original.data();
+}
+
+std::size_t PieceTable::getOriginalSize() const
+{
+	return mapping.isOpen() ? mapping.size() : original.size();
+}
+
+const char* PieceTable::getPieceData(const Piece& piece) const
+{
+	if (piece.source == Source::Original)
+	{
+		return getOriginalData() + piece.start;
+	}
+	else
+	{
+		return arena.getData(piece.start);
+	}
+}
+
+int PieceTable::findNode(unsigned int line) const
+{
+	if (line == cachedLine)
+	{
+		return cachedNode;
+	}
+
+	int node = root;
+	unsigned int lineToFind = line;
+
+	while (node != -1)
+	{
+		unsigned int numberOfLinesLeft = getNumberOfLines(nodes[node].left);
+
+		if (lineToFind < numberOfLinesLeft)
+		{
+			node = nodes[node].left;
+		}
+		else if (lineToFind == numberOfLinesLeft)
+		{
+			cachedLine = line;
+			cachedNode = node;
+
+			return node;
+		}
+		else
+		{
+			lineToFind -= numberOfLinesLeft + 1;
+			node = nodes[node].right;
+		}
+	}
+
+	return -1;
+}
+
+PieceTable::Piece PieceTable::makePiece(std::string_view text)
+{
+	// Empty lines don't need a block until something is typed
+	if (text.size() == 0)
+	{
+		return Piece {};
+	}
+
+	Piece piece { Source::Added, LineArena::getSizeClass(text.size()), 0, text.size() };
+	piece.start = arena.allocate(piece.sizeClass);
+	memcpy(arena.getData(piece.start), text.data(), text.size());
+
+	return piece;
+}
+
+// Makes sure the line has its own block that can hold at least
+// capacity characters, so it can be modified in place.
+PieceTable::Piece& PieceTable::makeLineWritable(unsigned int line, std::size_t capacity)
+{
+	Piece& piece = nodes[findNode(line)].piece;
+
+	if (piece.source == Source::Added && LineArena::getBlockSize(piece.sizeClass) >= capacity)
+	{
+		return piece;
+	}
+
+	unsigned char sizeClass = LineArena::getSizeClass(capacity);
+	std::size_t block = arena.allocate(sizeClass);
+
+	if (piece.length > 0)
+	{
+		memcpy(arena.getData(block), getPieceData(piece), piece.length);
+	}
+
+	if (piece.source == Source::Added)
+	{
+		arena.free(piece.start, piece.sizeClass);
+	}
+
+	piece.source = Source::Added;
+	piece.sizeClass = sizeClass;
+	piece.start = block;
+
+	return piece;
+}
+
+bool PieceTable::isInBlock(const Piece& piece, const char* pointer) const
+{
+	if (piece.source != Source::Added)
+	{
+		return false;
+	}
+
+	const char* block = arena.getData(piece.start);
+	return std::less_equal<const char*>()(block, pointer) &&
+		   std::less<const char*>()(pointer, block + LineArena::getBlockSize(piece.sizeClass));
+}
+
+template<typename Function>
+void PieceTable::forEachNode(int subtree, Function function) const
+{
+	std::vector<int> stack;
+
+	if (subtree != -1)
+	{
+		stack.push_back(subtree);
+	}
+
+	while (!stack.empty())
+	{
+		int node = stack.back();
+		stack.pop_back();
+
+		if (nodes[node].left != -1) stack.push_back(nodes[node].left);
+		if (nodes[node].right != -1) stack.push_back(nodes[node].right);
+
+		function(node);
+	}
+}
+
+bool PieceTable::shouldCompact() const
+{
+	// Only worth it once a lot of freed blocks aren't being reused
+	return arena.getNumberOfBytesFree() >= 1024 * 1024 &&
+		   arena.getNumberOfBytesFree() > arena.getNumberOfBytesInUse();
+}
+
+void PieceTable::compact()
+{
+	LineArena newArena;
+	newArena.numberOfHeapAllocations = arena.numberOfHeapAllocations;
+
+	forEachNode(root, [&](int node)
+	{
+		Piece& piece = nodes[node].piece;
+		if (piece.source != Source::Added) return;
+
+		// The blocks are made as small as they can be
+		unsigned char sizeClass = LineArena::getSizeClass(piece.length);
+		std::size_t block = newArena.allocate(sizeClass);
+		memcpy(newArena.getData(block), arena.getData(piece.start), piece.length);
+
+		piece.sizeClass = sizeClass;
+		piece.start = block;
+	});
+
+	arena = std::move(newArena);
+}
+
+unsigned int PieceTable::internLines()
+{
+	// NOTE(fkp): The keys are views into the old contents, so those
+	// have to stay alive until the end.
+	const char* oldData = getOriginalData();
+	std::unordered_map<std::string_view, std::size_t> internedOffsets;
+	std::string interned;
+
+	forEachNode(root, [&](int node)
+	{
+		Piece& piece = nodes[node].piece;
+		if (piece.source != Source::Original) return;
+
+		std::string_view text { oldData + piece.start, piece.length };
+		auto result = internedOffsets.try_emplace(text, interned.size());
+
+		if (result.second)
+		{
+			interned.append(text);
+		}
+
+		piece.start = result.first->second;
+	});
+
+	interned.shrink_to_fit();
+	mapping.close();
+	original = std::move(interned);
+	invalidateCache();
+
+	return (unsigned int) internedOffsets.size();
+}
+
+void PieceTable::getOriginalTextSizes(std::size_t& referencedSize, std::size_t& storedSize) const
+{
+	referencedSize = 0;
+	storedSize = getOriginalSize();
+
+	forEachNode(root, [&](int node)
+	{
+		if (nodes[node].piece.source == Source::Original)
+		{
+			referencedSize += nodes[node].piece.length;
+		}
+	});
+}
+
+
+int PieceTable::allocateNode(Piece piece)
+{
+	Node node;
+	node.piece = piece;
+	node.priority = nextRandom();
+	node.numberOfChars = piece.length + 1;
+
+	if (freeNodes.size() > 0)
+	{
+		int index = freeNodes.back();
+		freeNodes.pop_back();
+		nodes[index] = node;
+
+		return index;
+	}
+	else
+	{
+		nodes.push_back(node);
+		return (int) nodes.size() - 1;
+	}
+}
+
+void PieceTable::freeNode(int node)
+{
+	if (node != -1)
+	{
+		const Piece& piece = nodes[node].piece;
+
+		if (piece.source == Source::Added)
+		{
+			arena.free(piece.start, piece.sizeClass);
+		}
+		
+		freeNodes.push_back(node);
+	}
+}
+
+unsigned int PieceTable::getNumberOfLines(int node) const
+{
+	return node == -1 ? 0 : nodes[node].numberOfLines;
+}
+
+std::size_t PieceTable::getNumberOfChars(int node) const
+{
+	return node == -1 ? 0 : nodes[node].numberOfChars;
+}
+
+// Updates the character counts on the path down to the line after its
+// length has changed in place.
+void PieceTable::changeLineLength(unsigned int line, std::ptrdiff_t change)
+{
+	int node = root;
+
+	while (node != -1)
+	{
+		nodes[node].numberOfChars += change;
+		unsigned int numberOfLinesLeft = getNumberOfLines(nodes[node].left);
+
+		if (line < numberOfLinesLeft)
+		{
+			node = nodes[node].left;
+		}
+		else if (line == numberOfLinesLeft)
+		{
+			return;
+		}
+		else
+		{
+			line -= numberOfLinesLeft + 1;
+			node = nodes[node].right;
+		}
+	}
+}
+
+void PieceTable::update(int node)
+{
+	nodes[node].numberOfLines = 1 + getNumberOfLines(nodes[node].left) + getNumberOfLines(nodes[node].right);
+	nodes[node].numberOfChars = nodes[node].piece.length + 1 + getNumberOfChars(nodes[node].left) + getNumberOfChars(nodes[node].right);
+}
+
+// Splits the tree into the first numberOfLinesLeft lines and the rest
+void PieceTable::split(int node, unsigned int numberOfLinesLeft, int& left, int& right)
+{
+	if (node == -1)
+	{
+		left = -1;
+		right = -1;
+		return;
+	}
+
+	unsigned int numberOfLinesInLeftChild = getNumberOfLines(nodes[node].left);
+
+	if (numberOfLinesLeft <= numberOfLinesInLeftChild)
+	{
+		int leftOfLeftChild;
+		int rightOfLeftChild;
+		split(nodes[node].left, numberOfLinesLeft, leftOfLeftChild, rightOfLeftChild);
+
+		nodes[node].left = rightOfLeftChild;
+		left = leftOfLeftChild;
+		right = node;
+	}
+	else
+	{
+		int leftOfRightChild;
+		int rightOfRightChild;
+		split(nodes[node].right, numberOfLinesLeft - numberOfLinesInLeftChild - 1, leftOfRightChild, rightOfRightChild);
+
+		nodes[node].right = leftOfRightChild;
+		left = node;
+		right = rightOfRightChild;
+	}
+
+	update(node);
+}
+
+int PieceTable::merge(int left, int right)
+{
+	if (left == -1) return right;
+	if (right == -1) return left;
+
+	if (nodes[left].priority > nodes[right].priority)
+	{
+		int newRight = merge(nodes[left].right, right);
+		nodes[left].right = newRight;
+		update(left);
+
+		return left;
+	}
+	else
+	{
+		int newLeft = merge(left, nodes[right].left);
+		nodes[right].left = newLeft;
+		update(right);
+
+		return right;
+	}
+}
+
+unsigned int PieceTable::nextRandom()
+{
+	// xorshift32
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+
+	return randomState;
+}
+
+void PieceTable::invalidateCache()
+{
+	cachedLine = (unsigned int) -1;
+	cachedNode = -1;
+}
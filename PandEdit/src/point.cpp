@@ -1,5 +1,7 @@
 //  ===== Date Created: 28 April, 2020 ===== 
 
+#include <algorithm>
+
 #include "point.hpp"
 #include "buffer.hpp"
 #include "frame.hpp"
@@ -19,6 +21,16 @@ Point Point::operator+(int number)
 {
 	Point result = *this;
 
+	// NOTE(fkp): Single steps are cheaper to walk than to look up
+	if (number > 1 && canUseOffsets())
+	{
+		std::size_t offset = buffer->offsetOf(*this) + number;
+		result = buffer->pointAt(std::min(offset, buffer->data.getNumberOfChars()));
+		result.targetCol = targetCol;
+
+		return result;
+	}
+
 	for (int i = 0; i < number; i++)
 	{
 		result++;
@@ -31,6 +43,15 @@ Point Point::operator-(int number)
 {
 	Point result = *this;
 
+	if (number > 1 && canUseOffsets())
+	{
+		std::size_t offset = buffer->offsetOf(*this);
+		result = buffer->pointAt(offset > (std::size_t) number ? offset - number : 0);
+		result.targetCol = targetCol;
+
+		return result;
+	}
+
 	for (int i = 0; i < number; i++)
 	{
 		result--;
@@ -188,20 +209,18 @@ Point& Point::movePrevious()
 
 unsigned int Point::distanceTo(const Point& other) const
 {
-	int count = 0;
-	Point location = *this;
-	
-	while (location < other)
+	if (!buffer)
 	{
-		count += 1;
-		location++;
+		ERROR_ONCE("Error: Cannot use Point::distanceTo(), no buffer provided.\n");
+		return 0;
 	}
 
-	while (location > other)
-	{
-		count += 1;
-		location--;
-	}
+	return (unsigned int) buffer->distance(*this, other);
+}
 
-	return count;
+// The minibuffer can't move into its prompt, and points outside the
+// buffer don't move at all, so those still have to step one by one.
+bool Point::canUseOffsets()
+{
+	return buffer && buffer->type != BufferType::MiniBuffer && isInBuffer();
 }
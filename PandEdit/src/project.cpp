@@ -14,6 +14,7 @@
 #include "renderer.hpp"
 #include "font.hpp"
 #include "commands.hpp"
+#include "child_process.hpp"
 
 // NOTE(fkp): Volatile! Ensure this is synced with loadFromFile()
 void Project::saveToFile(const std::string& path, const Window& window)
@@ -228,7 +229,7 @@ void Project::loadFromFile(const std::string& path, Window& window)
 				READ_STRING_UNTIL_COMMA(frameBufferName);
 				READ_STRING_UNTIL_COMMA(frameBufferPath);
 
-				frame->currentBuffer = new Buffer(BufferType(frameBufferTypeInt), frameBufferName, frameBufferPath);
+				frame->switchToBuffer(new Buffer(BufferType(frameBufferTypeInt), frameBufferName, frameBufferPath));
 
 				if (frame->currentBuffer->type == BufferType::MiniBuffer)
 				{
@@ -347,10 +348,10 @@ void waitForCompilationToFinish(HANDLE hProcess, HANDLE childStdoutRead, Buffer*
 		if (!hasDeletedFirstLine)
 		{
 			hasDeletedFirstLine = true;
-			compileBuffer->data.pop_back();
+			compileBuffer->data.eraseLine(compileBuffer->data.size() - 1);
 		}
 		
-		compileBuffer->data.push_back(buffer);
+		compileBuffer->data.appendLine(buffer);
 	}
 
 	// Gets the exit code
@@ -398,90 +399,23 @@ bool Project::executeCompileCommand(Buffer* compileBuffer)
 		return false;
 	}
 
-	// Makes the command a modifiable char* because Windows wants that
-	// for some reason
-	char* compileCommandCStr = new char[compileCommand.size() + 1];
-	std::copy(compileCommand.begin(), compileCommand.end(), compileCommandCStr);
-	compileCommandCStr[compileCommand.size()] = '\0';
-	
-	//
-	// NOTE(fkp): Pipe setup
-	//
-	
-	HANDLE childStdOutRead = nullptr;
-	HANDLE childStdOutWrite = nullptr;
-	HANDLE childStdInRead = nullptr;
-	HANDLE childStdInWrite = nullptr;
-	
-	SECURITY_ATTRIBUTES securityAttributes {};
-	securityAttributes.nLength = sizeof(securityAttributes);
-	securityAttributes.bInheritHandle = true;
-	securityAttributes.lpSecurityDescriptor = nullptr;
-
- 	// Create a pipe for the child process's STDOUT
-	if (!CreatePipe(&childStdOutRead, &childStdOutWrite, &securityAttributes, 0))
-	{
-		printf("Error: Failed to create child process's STDOUT handle.\n");
-		return false;
-	}
-
-	// Ensure child's STDOUT read handle is not inherited
-	if (!SetHandleInformation(childStdOutRead, HANDLE_FLAG_INHERIT, 0))
-	{
-		printf("Error: Failed to ensure child process's STDOUT read handle is not inherited.\n");
-		return false;
-	}
+	ChildProcess childProcess;
 
- 	// Create a pipe for the child process's STDIN
-	if (!CreatePipe(&childStdInRead, &childStdInWrite, &securityAttributes, 0))
+	if (!startChildProcess(compileCommand, childProcess))
 	{
-		printf("Error: Failed to create child process's STDIN handle.\n");
 		return false;
 	}
 
-	// Ensure child's STDIN write handle is not inherited
-	if (!SetHandleInformation(childStdInWrite, HANDLE_FLAG_INHERIT, 0))
-	{
-		printf("Error: Failed to ensure child process's STDIN write handle is not inherited.\n");
-		return false;
-	}
+	std::promise<bool> compilePromise;
+	compileFuture = compilePromise.get_future();
 
-	
-	//
-	// NOTE(fkp): Process creation
-	//
-
-	PROCESS_INFORMATION processInformation {};
-	STARTUPINFO startupInfo {};
-	startupInfo.cb = sizeof(startupInfo);
-	startupInfo.hStdError = childStdOutWrite;
-	startupInfo.hStdOutput = childStdOutWrite;
-	startupInfo.hStdInput = childStdInRead;
-	startupInfo.dwFlags = STARTF_USESTDHANDLES;
-
-	if (CreateProcess(nullptr, compileCommandCStr,
-					  nullptr, nullptr, true, 0, nullptr, nullptr,
-					  &startupInfo, &processInformation))
-	{
-		std::promise<bool> compilePromise;
-		compileFuture = compilePromise.get_future();
+	// NOTE(fkp): childProcess.stdOutRead and childProcess.process will
+	// be closed in waitForCompilationToFinish()
+	compileThread = std::thread { waitForCompilationToFinish, childProcess.process, childProcess.stdOutRead, compileBuffer };
+	compileThread.detach();
 
-		compileThread = std::thread { waitForCompilationToFinish, processInformation.hProcess, childStdOutRead, compileBuffer };
-		compileThread.detach();
-		
-		// Closes unneeded handles
-		// NOTE(fkp): childStdOutRead and processInformation.hProcess
-		// will be closed in waitForCompilationToFinish()
-		CloseHandle(processInformation.hThread);
-		CloseHandle(childStdOutWrite);
-		CloseHandle(childStdInRead);
-		CloseHandle(childStdInWrite);
-	}
-	else
-	{
-		printf("Error: Failed to create child process.\n");
-		return false;
-	}
+	// The compiler isn't given any input
+	CloseHandle(childProcess.stdInWrite);
 
 	return true;
 }
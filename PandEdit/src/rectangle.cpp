@@ -0,0 +1,84 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+
+#include "rectangle.hpp"
+#include "frame.hpp"
+
+static unsigned int getCharWidth(char character, unsigned int column, unsigned int tabWidth)
+{
+	if (character == '\t')
+	{
+		return getNumberOfColumnsToNextTabStop(tabWidth, column);
+	}
+
+	return 1;
+}
+
+unsigned int getVisualColumn(std::string_view line, unsigned int col, unsigned int tabWidth)
+{
+	unsigned int column = 0;
+	col = std::min<unsigned int>(col, (unsigned int) line.size());
+
+	for (unsigned int i = 0; i < col; i++)
+	{
+		column += getCharWidth(line[i], column, tabWidth);
+	}
+
+	return column;
+}
+
+RectangleSlice sliceRectangle(std::string_view line, unsigned int leftColumn, unsigned int rightColumn, unsigned int tabWidth)
+{
+	RectangleSlice slice;
+	unsigned int column = 0;
+	unsigned int i = 0;
+
+	// Up to the left edge, stopping at a tab that crosses it
+	while (i < line.size() && column < leftColumn)
+	{
+		unsigned int width = getCharWidth(line[i], column, tabWidth);
+
+		if (column + width > leftColumn)
+		{
+			break;
+		}
+
+		column += width;
+		i += 1;
+	}
+
+	// NOTE(fkp): A tab split by an edge is replaced, so the part of it
+	// outside the rectangle becomes padding.
+	slice.startCol = i;
+	slice.paddingBefore = leftColumn - std::min(column, leftColumn);
+
+	while (i < line.size() && column < rightColumn)
+	{
+		unsigned int width = getCharWidth(line[i], column, tabWidth);
+
+		if (line[i] == '\t')
+		{
+			// Only the part of the tab inside the rectangle
+			unsigned int overlapStart = std::max(column, leftColumn);
+			unsigned int overlapEnd = std::min(column + width, rightColumn);
+			slice.text.append(overlapEnd - overlapStart, ' ');
+		}
+		else
+		{
+			slice.text += line[i];
+		}
+
+		if (column + width > rightColumn)
+		{
+			slice.paddingAfter = column + width - rightColumn;
+		}
+
+		column += width;
+		i += 1;
+	}
+
+	slice.endCol = i;
+
+	return slice;
+}
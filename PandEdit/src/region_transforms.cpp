@@ -0,0 +1,209 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <unordered_set>
+
+#include "region_transforms.hpp"
+#include "run_on_threads.hpp"
+
+std::vector<std::string_view> splitIntoLines(std::string_view text)
+{
+	std::vector<std::string_view> lines;
+	std::size_t lineStart = 0;
+
+	while (true)
+	{
+		std::size_t newline = text.find('\n', lineStart);
+
+		if (newline == std::string_view::npos)
+		{
+			lines.push_back(text.substr(lineStart));
+			break;
+		}
+
+		lines.push_back(text.substr(lineStart, newline - lineStart));
+		lineStart = newline + 1;
+	}
+
+	return lines;
+}
+
+std::string joinWithNewlines(const std::vector<std::string_view>& lines)
+{
+	std::size_t size = lines.size() > 0 ? lines.size() - 1 : 0;
+
+	for (std::string_view line : lines)
+	{
+		size += line.size();
+	}
+
+	std::string text;
+	text.reserve(size);
+
+	for (std::size_t i = 0; i < lines.size(); i++)
+	{
+		if (i > 0) text += '\n';
+		text += lines[i];
+	}
+
+	return text;
+}
+
+// The first few characters of a line packed so they compare in the same
+// order as the text, most comparisons can stop at this.
+struct SortKey
+{
+	std::uint64_t prefix;
+	std::string_view line;
+
+	bool operator<(const SortKey& other) const
+	{
+		if (prefix != other.prefix)
+		{
+			return prefix < other.prefix;
+		}
+
+		return line < other.line;
+	}
+};
+
+static std::uint64_t getSortPrefix(std::string_view line)
+{
+	std::uint64_t prefix = 0;
+
+	for (std::size_t i = 0; i < sizeof(prefix); i++)
+	{
+		prefix <<= 8;
+
+		if (i < line.size())
+		{
+			prefix |= (unsigned char) line[i];
+		}
+	}
+
+	return prefix;
+}
+
+void sortLines(std::vector<std::string_view>& lines)
+{
+	// Smaller chunks aren't worth starting a thread for
+	constexpr std::size_t MIN_LINES_PER_THREAD = 64 * 1024;
+	std::size_t numberOfThreads = std::max<std::size_t>(1, std::min<std::size_t>(std::thread::hardware_concurrency(), lines.size() / MIN_LINES_PER_THREAD));
+
+	std::vector<std::size_t> chunkStarts;
+
+	for (std::size_t i = 0; i < numberOfThreads; i++)
+	{
+		chunkStarts.push_back(lines.size() * i / numberOfThreads);
+	}
+
+	chunkStarts.push_back(lines.size());
+
+	std::vector<SortKey> keys(lines.size());
+
+	runOnThreads(numberOfThreads, [&](std::size_t chunk)
+				 {
+					 for (std::size_t i = chunkStarts[chunk]; i < chunkStarts[chunk + 1]; i++)
+					 {
+						 keys[i] = { getSortPrefix(lines[i]), lines[i] };
+					 }
+
+					 std::sort(keys.begin() + chunkStarts[chunk], keys.begin() + chunkStarts[chunk + 1]);
+				 });
+
+	// Merges neighbouring chunks until there's only one, each round's
+	// merges are independent so they run at the same time too.
+	while (chunkStarts.size() > 2)
+	{
+		std::vector<std::size_t> mergedChunkStarts;
+
+		for (std::size_t i = 0; i + 1 < chunkStarts.size(); i += 2)
+		{
+			mergedChunkStarts.push_back(chunkStarts[i]);
+		}
+
+		mergedChunkStarts.push_back(lines.size());
+
+		runOnThreads(mergedChunkStarts.size() - 1, [&](std::size_t merge)
+					 {
+						 std::size_t first = merge * 2;
+
+						 if (first + 2 < chunkStarts.size())
+						 {
+							 std::inplace_merge(keys.begin() + chunkStarts[first], keys.begin() + chunkStarts[first + 1], keys.begin() + chunkStarts[first + 2]);
+						 }
+					 });
+
+		chunkStarts = std::move(mergedChunkStarts);
+	}
+
+	for (std::size_t i = 0; i < lines.size(); i++)
+	{
+		lines[i] = keys[i].line;
+	}
+}
+
+void uniqueLines(std::vector<std::string_view>& lines)
+{
+	std::unordered_set<std::string_view> seenLines;
+	seenLines.reserve(lines.size());
+
+	lines.erase(std::remove_if(lines.begin(), lines.end(), [&seenLines](std::string_view line)
+							   {
+								   return !seenLines.insert(line).second;
+							   }), lines.end());
+}
+
+void reverseLines(std::vector<std::string_view>& lines)
+{
+	std::reverse(lines.begin(), lines.end());
+}
+
+void trimTrailingWhitespace(std::vector<std::string_view>& lines)
+{
+	for (std::string_view& line : lines)
+	{
+		std::size_t lastCharacter = line.find_last_not_of(" \t");
+		line = line.substr(0, lastCharacter == std::string_view::npos ? 0 : lastCharacter + 1);
+	}
+}
+
+void alignLines(std::vector<std::string_view>& lines, std::string_view delimiter, std::vector<std::string>& alignedLines)
+{
+	// NOTE(fkp): This counts characters, so tabs before the delimiter
+	// will throw it off.
+	std::size_t alignedCol = 0;
+
+	for (std::string_view line : lines)
+	{
+		std::size_t col = line.find(delimiter);
+
+		if (col != std::string_view::npos)
+		{
+			alignedCol = std::max(alignedCol, col);
+		}
+	}
+
+	// NOTE(fkp): This can't reallocate, the views point into it
+	alignedLines.clear();
+	alignedLines.reserve(lines.size());
+
+	for (std::string_view& line : lines)
+	{
+		std::size_t col = line.find(delimiter);
+
+		if (col == std::string_view::npos || col == alignedCol)
+		{
+			continue;
+		}
+
+		std::string alignedLine { line.substr(0, col) };
+		alignedLine.append(alignedCol - col, ' ');
+		alignedLine += line.substr(col);
+
+		alignedLines.push_back(std::move(alignedLine));
+		line = alignedLines.back();
+	}
+}
@@ -401,7 +401,8 @@ void Renderer::drawFrame(Frame& frame)
 			break;
 		}
 
-		visibleLines += buffer.data[i] + std::string(1, '\n');
+		visibleLines += buffer.data[i];
+		visibleLines += '\n';
 		y += currentFont->size;
 		numberOfLines += 1;
 	}
@@ -527,6 +528,37 @@ void Renderer::drawFrame(Frame& frame)
 		}
 	}
 
+	//
+	// Other cursors
+	//
+
+	if (frame.cursors.size() > 0)
+	{
+		glUseProgram(shapeShader.programID);
+		glUniform4f(glGetUniformLocation(shapeShader.programID, "colour"), 1.0f, 1.0f, 1.0f, 1.0f);
+		unsigned int borderWidth = 1 + (currentFont->size / 24);
+
+		for (const std::unique_ptr<Point>& cursor : frame.cursors)
+		{
+			if ((int) cursor->line < frame.currentTopLine ||
+				(int) cursor->line >= frame.currentTopLine + (int) frame.numberOfLinesInView)
+			{
+				continue;
+			}
+
+			float cursorX;
+			float cursorY;
+			float cursorWidth;
+			float cursorHeight;
+			frame.getPointRect(currentFont, tabWidth, framePixelX, framePixelY, &cursorX, &cursorY, &cursorWidth, &cursorHeight, cursor.get());
+
+			if (cursorX + cursorWidth <= framePixelX + framePixelWidth)
+			{
+				drawHollowRect(cursorX, cursorY, cursorWidth, cursorHeight, (float) borderWidth);
+			}
+		}
+	}
+
 	//
 	// Mode line
 	//
@@ -555,11 +587,42 @@ void Renderer::drawFrame(Frame& frame)
 		}
 		
 		modeLineTextString += " (LINE: ";
-		modeLineTextString += std::to_string(frame.point.line + 1);
+
+		if (buffer.isPaged())
+		{
+			std::uint64_t firstPagedLine;
+
+			if (buffer.getFirstPagedLine(firstPagedLine))
+			{
+				modeLineTextString += std::to_string(firstPagedLine + frame.point.line + 1);
+			}
+			else
+			{
+				modeLineTextString += "?";
+			}
+		}
+		else
+		{
+			modeLineTextString += std::to_string(frame.point.line + 1);
+		}
+		
 		modeLineTextString += ", COL: ";
 		modeLineTextString += std::to_string(frame.point.col);
 		modeLineTextString += ")";
 
+		if (buffer.isPaged() && !buffer.pagedFile->isIndexComplete())
+		{
+			modeLineTextString += " [Indexing: ";
+			modeLineTextString += std::to_string((int) (buffer.pagedFile->getIndexProgress() * 100.0));
+			modeLineTextString += "%]";
+		}
+		else if (buffer.isLoading())
+		{
+			modeLineTextString += " [Loading: ";
+			modeLineTextString += std::to_string((int) (buffer.loader->getProgress() * 100.0));
+			modeLineTextString += "%]";
+		}
+
 		TextToDraw modeLineText { modeLineTextString };
 		
 		if (&frame == Frame::currentFrame)
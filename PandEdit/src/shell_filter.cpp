@@ -0,0 +1,182 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+#include <vector>
+
+#include "shell_filter.hpp"
+#include "child_process.hpp"
+
+ShellFilter::~ShellFilter()
+{
+	if (!isFinished())
+	{
+		cancel();
+	}
+
+	waitUntilFinished();
+}
+
+bool ShellFilter::start(const std::string& shellCommand, std::string&& text)
+{
+	command = shellCommand;
+	input = std::move(text);
+	output.clear();
+
+	ChildProcess childProcess;
+
+	// NOTE(fkp): The command is really run by whatever cmd.exe starts,
+	// so the job is what lets cancel() kill that too.
+	if (!startChildProcess("cmd.exe /C " + command, childProcess, true))
+	{
+		return false;
+	}
+
+	process = childProcess.process;
+	job = childProcess.job;
+	stdInWrite = childProcess.stdInWrite;
+	stdOutRead = childProcess.stdOutRead;
+
+	timer.reset();
+	isReadThreadDone = false;
+	wasCancelled = false;
+	writeThread = std::thread(&ShellFilter::write, this);
+	readThread = std::thread(&ShellFilter::read, this);
+
+	return true;
+}
+
+void ShellFilter::cancel()
+{
+	wasCancelled = true;
+
+	// NOTE(fkp): Killing only cmd.exe would leave the command it started
+	// running, still holding both pipes open.
+	if (job)
+	{
+		TerminateJobObject(job, 1);
+	}
+	else if (process)
+	{
+		TerminateProcess(process, 1);
+	}
+
+	// The pipes are broken once everything is dead, but this makes sure
+	// neither thread can stay stuck in a read or write. The threads close
+	// their own pipes after that, closing them here could pull a handle
+	// out from under a thread still using it.
+	if (writeThread.joinable())
+	{
+		CancelSynchronousIo((HANDLE) writeThread.native_handle());
+	}
+
+	if (readThread.joinable())
+	{
+		CancelSynchronousIo((HANDLE) readThread.native_handle());
+	}
+}
+
+void ShellFilter::waitUntilFinished()
+{
+	if (writeThread.joinable())
+	{
+		writeThread.join();
+	}
+
+	if (readThread.joinable())
+	{
+		readThread.join();
+	}
+
+	if (process)
+	{
+		CloseHandle(process);
+		process = nullptr;
+	}
+
+	if (job)
+	{
+		CloseHandle(job);
+		job = nullptr;
+	}
+}
+
+bool ShellFilter::isFinished() const
+{
+	return isReadThreadDone;
+}
+
+std::string ShellFilter::takeOutput()
+{
+	waitUntilFinished();
+	return std::move(output);
+}
+
+// NOTE(fkp): This runs on its own thread
+void ShellFilter::write()
+{
+	std::size_t offset = 0;
+
+	while (offset < input.size() && !wasCancelled)
+	{
+		DWORD sizeToWrite = (DWORD) std::min(WRITE_SIZE, input.size() - offset);
+		DWORD numberWritten = 0;
+
+		// Fails once the command exits (or is killed) without reading everything
+		if (!WriteFile(stdInWrite, input.data() + offset, sizeToWrite, &numberWritten, nullptr))
+		{
+			break;
+		}
+
+		offset += numberWritten;
+		numberOfBytesWritten = offset;
+	}
+
+	// Closing it is what tells the command there's no more input
+	closePipe(stdInWrite);
+}
+
+// NOTE(fkp): This runs on its own thread
+void ShellFilter::read()
+{
+	std::vector<char> chunk(READ_SIZE);
+
+	while (!wasCancelled)
+	{
+		DWORD numberRead = 0;
+
+		if (!ReadFile(stdOutRead, chunk.data(), (DWORD) chunk.size(), &numberRead, nullptr) || numberRead == 0)
+		{
+			break;
+		}
+
+		output.append(chunk.data(), numberRead);
+		numberOfBytesRead += numberRead;
+	}
+
+	closePipe(stdOutRead);
+
+	// The output is all there once STDOUT is closed, but the exit code
+	// has to wait for the process itself. A cancelled one has no exit
+	// code worth waiting for.
+	DWORD processExitCode;
+
+	if (!wasCancelled &&
+		WaitForSingleObject(process, INFINITE) == WAIT_OBJECT_0 &&
+		GetExitCodeProcess(process, &processExitCode))
+	{
+		exitCode = processExitCode;
+		didExit = true;
+	}
+
+	elapsedMs = timer.getElapsedMs();
+	isReadThreadDone = true;
+}
+
+void ShellFilter::closePipe(void*& pipe)
+{
+	if (pipe)
+	{
+		CloseHandle(pipe);
+		pipe = nullptr;
+	}
+}
@@ -0,0 +1,486 @@
+//  ===== Date Created: 17 October, 2026 =====
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdio.h>
+
+#include "undo_tree.hpp"
+
+// NOTE(fkp): A small LZ77 style format. A control byte below 128 is
+// followed by that many plus one literal bytes. Otherwise the low seven
+// bits are the length of a match (minus MIN_MATCH), followed by a two
+// byte offset back into the output.
+static constexpr std::size_t MIN_MATCH = 4;
+static constexpr std::size_t MAX_MATCH = MIN_MATCH + 127;
+static constexpr std::size_t MAX_LITERALS = 128;
+static constexpr std::size_t MAX_OFFSET = 65535;
+static constexpr unsigned int HASH_BITS = 12;
+
+static unsigned int hashFourBytes(const char* data)
+{
+	std::uint32_t value;
+	memcpy(&value, data, sizeof(value));
+
+	return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static std::string compress(std::string_view text)
+{
+	std::string output;
+	output.reserve(text.size());
+
+	std::vector<std::int64_t> lastPositions(1 << HASH_BITS, -1);
+	std::size_t literalStart = 0;
+	std::size_t position = 0;
+
+	auto flushLiterals = [&](std::size_t end)
+	{
+		while (literalStart < end)
+		{
+			std::size_t count = std::min(end - literalStart, MAX_LITERALS);
+			output += (char) (count - 1);
+			output.append(text.data() + literalStart, count);
+			literalStart += count;
+		}
+	};
+
+	while (position + MIN_MATCH <= text.size())
+	{
+		unsigned int hash = hashFourBytes(text.data() + position);
+		std::int64_t candidate = lastPositions[hash];
+		lastPositions[hash] = (std::int64_t) position;
+
+		if (candidate >= 0 && position - candidate <= MAX_OFFSET &&
+			memcmp(text.data() + candidate, text.data() + position, MIN_MATCH) == 0)
+		{
+			std::size_t length = MIN_MATCH;
+
+			while (length < MAX_MATCH && position + length < text.size() &&
+				   text[candidate + length] == text[position + length])
+			{
+				length += 1;
+			}
+
+			flushLiterals(position);
+
+			std::size_t offset = position - candidate;
+			output += (char) (0x80 | (length - MIN_MATCH));
+			output += (char) (offset & 0xff);
+			output += (char) (offset >> 8);
+
+			position += length;
+			literalStart = position;
+		}
+		else
+		{
+			position += 1;
+		}
+	}
+
+	flushLiterals(text.size());
+	return output;
+}
+
+static bool decompress(std::string_view input, std::string& output, std::size_t size)
+{
+	output.clear();
+	output.reserve(size);
+
+	std::size_t position = 0;
+
+	while (position < input.size())
+	{
+		unsigned char control = (unsigned char) input[position++];
+
+		if (control < 0x80)
+		{
+			std::size_t count = (std::size_t) control + 1;
+			if (position + count > input.size()) return false;
+
+			output.append(input.data() + position, count);
+			position += count;
+		}
+		else
+		{
+			if (position + 2 > input.size()) return false;
+
+			std::size_t length = (control & 0x7f) + MIN_MATCH;
+			std::size_t offset = (unsigned char) input[position] | ((std::size_t) (unsigned char) input[position + 1] << 8);
+			position += 2;
+
+			if (offset == 0 || offset > output.size()) return false;
+
+			// NOTE(fkp): The match can overlap what it is copying
+			std::size_t matchStart = output.size() - offset;
+
+			for (std::size_t i = 0; i < length; i++)
+			{
+				output += output[matchStart + i];
+			}
+		}
+	}
+
+	return output.size() == size;
+}
+
+UndoTree::UndoTree()
+{
+	clear();
+}
+
+UndoTree::~UndoTree()
+{
+	clear();
+}
+
+void UndoTree::clear()
+{
+	nodes.clear();
+	nodes.emplace_back();
+	current = 0;
+	arena.clear();
+
+	nextNodeToCompress = 1;
+	nextNodeToSpill = 1;
+	numberOfCompressedActions = 0;
+	numberOfSpilledActions = 0;
+
+	if (spillFile.is_open())
+	{
+		spillFile.close();
+	}
+
+	if (spillPath != "")
+	{
+		std::error_code error;
+		std::filesystem::remove(spillPath, error);
+		spillPath = "";
+	}
+
+	spillFileSize = 0;
+	canSpill = true;
+}
+
+void UndoTree::add(ActionType type, const Point& start, const Point& end, std::string_view text, bool continuesGroup)
+{
+	Node node;
+	node.type = type;
+	node.continuesGroup = continuesGroup && current != 0;
+	node.startLine = start.line;
+	node.startCol = start.col;
+	node.endLine = end.line;
+	node.endCol = end.col;
+	node.parent = current;
+	node.nextSibling = nodes[current].firstChild;
+	node.depth = nodes[current].depth + 1;
+	storeText(node, text);
+
+	int newNode = (int) nodes.size();
+	nodes.push_back(node);
+	nodes[current].firstChild = newNode;
+	nodes[current].redoChild = newNode;
+	current = newNode;
+
+	enforceMemoryBudget();
+}
+
+bool UndoTree::canAppendToCurrent(ActionType type) const
+{
+	const Node& node = nodes[current];
+
+	return current != 0 && node.type == type && node.firstChild == -1 &&
+		   !node.isCompressed && !node.isSpilled;
+}
+
+void UndoTree::appendToCurrent(std::string_view text, const Point& newEnd)
+{
+	Node& node = nodes[current];
+	std::size_t newSize = node.textSize + text.size();
+
+	if (node.storedSize == 0 || LineArena::getBlockSize(node.sizeClass) < newSize)
+	{
+		// Moves to a bigger block, doubling so appending stays cheap
+		unsigned char sizeClass = LineArena::getSizeClass(newSize * 2);
+		std::size_t block = arena.allocate(sizeClass);
+
+		if (node.storedSize > 0)
+		{
+			memcpy(arena.getData(block), arena.getData(node.payload), node.storedSize);
+			arena.free(node.payload, node.sizeClass);
+		}
+
+		node.payload = block;
+		node.sizeClass = sizeClass;
+	}
+
+	memcpy(arena.getData(node.payload) + node.storedSize, text.data(), text.size());
+	node.storedSize = (std::uint32_t) newSize;
+	node.textSize = (std::uint32_t) newSize;
+	node.endLine = newEnd.line;
+	node.endCol = newEnd.col;
+
+	enforceMemoryBudget();
+}
+
+Point UndoTree::getCurrentStart() const
+{
+	return Point { nodes[current].startLine, nodes[current].startCol };
+}
+
+Point UndoTree::getCurrentEnd() const
+{
+	return Point { nodes[current].endLine, nodes[current].endCol };
+}
+
+bool UndoTree::undo(std::vector<Action>& actions)
+{
+	actions.clear();
+
+	while (current != 0)
+	{
+		const Node& node = nodes[current];
+		actions.emplace_back();
+		fillAction(node, actions.back());
+
+		// Redo comes back down this branch
+		bool isStartOfGroup = !node.continuesGroup;
+		nodes[node.parent].redoChild = current;
+		current = node.parent;
+
+		if (isStartOfGroup) break;
+	}
+
+	return actions.size() > 0;
+}
+
+bool UndoTree::redo(std::vector<Action>& actions)
+{
+	actions.clear();
+	int child = nodes[current].redoChild;
+
+	if (child == -1)
+	{
+		return false;
+	}
+
+	do
+	{
+		current = child;
+		actions.emplace_back();
+		fillAction(nodes[current], actions.back());
+
+		child = nodes[current].redoChild;
+	} while (child != -1 && nodes[child].continuesGroup);
+
+	return true;
+}
+
+unsigned int UndoTree::switchBranch(unsigned int& branchIndex)
+{
+	Node& node = nodes[current];
+	unsigned int numberOfBranches = 0;
+	branchIndex = 0;
+
+	for (int child = node.firstChild; child != -1; child = nodes[child].nextSibling)
+	{
+		numberOfBranches += 1;
+	}
+
+	if (numberOfBranches == 0)
+	{
+		return 0;
+	}
+
+	// Children are newest first, this goes to the next oldest one
+	int next = node.redoChild != -1 ? nodes[node.redoChild].nextSibling : -1;
+	node.redoChild = next != -1 ? next : node.firstChild;
+
+	for (int child = node.firstChild; child != node.redoChild; child = nodes[child].nextSibling)
+	{
+		branchIndex += 1;
+	}
+
+	return numberOfBranches;
+}
+
+UndoTree::Stats UndoTree::getStats() const
+{
+	Stats stats;
+	stats.depth = nodes[current].depth;
+	stats.numberOfActions = (unsigned int) nodes.size() - 1;
+	stats.numberOfBytesInMemory = arena.getNumberOfBytesInUse();
+	stats.numberOfCompressedActions = numberOfCompressedActions;
+	stats.numberOfSpilledActions = numberOfSpilledActions;
+	stats.numberOfBytesSpilled = spillFileSize;
+
+	for (const Node& node : nodes)
+	{
+		if (node.firstChild != -1 && nodes[node.firstChild].nextSibling != -1)
+		{
+			stats.numberOfBranches += 1;
+		}
+	}
+
+	return stats;
+}
+
+void UndoTree::storeText(Node& node, std::string_view text)
+{
+	node.textSize = (std::uint32_t) text.size();
+	node.storedSize = (std::uint32_t) text.size();
+
+	if (text.size() == 0)
+	{
+		return;
+	}
+
+	node.sizeClass = LineArena::getSizeClass(text.size());
+	node.payload = arena.allocate(node.sizeClass);
+	memcpy(arena.getData(node.payload), text.data(), text.size());
+}
+
+std::string UndoTree::loadText(const Node& node)
+{
+	std::string stored;
+
+	if (node.storedSize == 0)
+	{
+		return stored;
+	}
+
+	if (node.isSpilled)
+	{
+		stored.resize(node.storedSize);
+		spillFile.clear();
+		spillFile.seekg((std::streamoff) node.payload);
+		spillFile.read(stored.data(), stored.size());
+
+		if ((std::size_t) spillFile.gcount() != stored.size())
+		{
+			printf("Error: Failed to read an undo action back from '%s'.\n", spillPath.c_str());
+			return "";
+		}
+	}
+	else
+	{
+		stored.assign(arena.getData(node.payload), node.storedSize);
+	}
+
+	if (!node.isCompressed)
+	{
+		return stored;
+	}
+
+	std::string text;
+
+	if (!decompress(stored, text, node.textSize))
+	{
+		printf("Error: A compressed undo action is corrupt.\n");
+		return "";
+	}
+
+	return text;
+}
+
+void UndoTree::fillAction(const Node& node, Action& action)
+{
+	action.type = node.type;
+	action.start = Point { node.startLine, node.startCol };
+	action.end = Point { node.endLine, node.endCol };
+	action.data = loadText(node);
+}
+
+void UndoTree::enforceMemoryBudget()
+{
+	if (arena.getNumberOfBytesInUse() <= memoryBudget || nodes.size() <= NUMBER_OF_RECENT_ACTIONS)
+	{
+		return;
+	}
+
+	std::size_t lastOldNode = nodes.size() - NUMBER_OF_RECENT_ACTIONS;
+
+	// Compressing is tried first, the oldest actions go first
+	while (arena.getNumberOfBytesInUse() > memoryBudget && nextNodeToCompress < lastOldNode)
+	{
+		Node& node = nodes[nextNodeToCompress++];
+		if (node.isCompressed || node.isSpilled || node.storedSize < 64) continue;
+
+		std::string compressed = compress(std::string_view { arena.getData(node.payload), node.storedSize });
+		if (compressed.size() >= node.storedSize) continue;
+
+		std::uint32_t textSize = node.textSize;
+		arena.free(node.payload, node.sizeClass);
+		storeText(node, compressed);
+		node.textSize = textSize;
+		node.isCompressed = true;
+		numberOfCompressedActions += 1;
+	}
+
+	while (arena.getNumberOfBytesInUse() > memoryBudget && nextNodeToSpill < nextNodeToCompress && canSpill)
+	{
+		Node& node = nodes[nextNodeToSpill++];
+		if (node.isSpilled || node.storedSize == 0) continue;
+
+		if (!openSpillFile())
+		{
+			return;
+		}
+
+		spillFile.clear();
+		spillFile.seekp((std::streamoff) spillFileSize);
+		spillFile.write(arena.getData(node.payload), node.storedSize);
+
+		if (!spillFile)
+		{
+			printf("Error: Failed to move an undo action out to '%s'.\n", spillPath.c_str());
+			canSpill = false;
+
+			return;
+		}
+
+		arena.free(node.payload, node.sizeClass);
+		node.isSpilled = true;
+		node.payload = spillFileSize;
+		spillFileSize += node.storedSize;
+		numberOfSpilledActions += 1;
+	}
+}
+
+bool UndoTree::openSpillFile()
+{
+	if (spillFile.is_open())
+	{
+		return true;
+	}
+
+	// NOTE(fkp): The file only lives as long as the undo tree
+	static unsigned int numberOfSpillFiles = 0;
+	std::error_code error;
+	std::filesystem::path directory = std::filesystem::temp_directory_path(error);
+
+	if (error)
+	{
+		printf("Error: No temporary directory to move undo history out to.\n");
+		canSpill = false;
+
+		return false;
+	}
+
+	long long uniqueNumber = (long long) std::chrono::steady_clock::now().time_since_epoch().count();
+	std::string filename = "pandedit-undo-" + std::to_string(uniqueNumber) + "-" + std::to_string(numberOfSpillFiles++) + ".tmp";
+	spillPath = (directory / filename).string();
+	spillFile.open(spillPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!spillFile)
+	{
+		printf("Error: Failed to open '%s' to move undo history out to.\n", spillPath.c_str());
+		spillPath = "";
+		canSpill = false;
+
+		return false;
+	}
+
+	return true;
+}
@@ -20,6 +20,7 @@
 #include "font.hpp"
 #include "commands.hpp"
 #include "keymap.hpp"
+#include "keyboard_macro.hpp"
 #include "file_util.hpp"
 
 Window::Window(unsigned int width, unsigned int height, const char* title)
@@ -144,6 +145,7 @@ LRESULT CALLBACK Window::eventCallback(HWND windowHandle, UINT message, WPARAM w
 
 		case VK_TAB:
 		{
+			KeyboardMacro::recordChar('\t');
 			Frame::currentFrame->insertChar('\t');
 		} break;
 		
@@ -152,7 +154,7 @@ LRESULT CALLBACK Window::eventCallback(HWND windowHandle, UINT message, WPARAM w
 			if (buffer.type == BufferType::MiniBuffer)
 			{
 				// Gets rid of the 'Execute: '
-				std::string commandText = buffer.data[0].substr(buffer.data[0].find(' '));
+				std::string commandText { buffer.data[0].substr(buffer.data[0].find(' ')) };
 
 				while (commandText.size() > 0 && commandText[0] == ' ')
 				{
@@ -163,6 +165,7 @@ LRESULT CALLBACK Window::eventCallback(HWND windowHandle, UINT message, WPARAM w
 			}
 			else
 			{
+				KeyboardMacro::recordChar('\n');
 				Frame::currentFrame->newLine();
 			}
 		} break;
@@ -188,6 +191,7 @@ LRESULT CALLBACK Window::eventCallback(HWND windowHandle, UINT message, WPARAM w
 		if (!IS_KEY_PRESSED(VK_CONTROL) &&
 			wParam >= 32 && wParam < 127)
 		{
+			KeyboardMacro::recordChar((char) wParam);
 			Frame::currentFrame->insertChar((char) wParam);
 		}
 